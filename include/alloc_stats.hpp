@@ -0,0 +1,185 @@
+/**
+ * alloc_stats.hpp - allocator counters kept in the buffer so any
+ * process attached to it can see what the allocator is doing, e.g.,
+ * to tell a fragmented buffer from a full one when allocate_record
+ * starts returning nullptr. Each thread tallies its own allocations
+ * and frees (local_alloc_stats) and adds them to the buffer's every
+ * flush_interval operations and on close, so those lag by at most
+ * that much per thread, failures and semaphore waits go straight in.
+ * ipc::buffer::get_stats puts it all together with a walk of the
+ * heap for the free run histogram.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 14:02:55 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef ALLOC_STATS_HPP
+#define ALLOC_STATS_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+namespace ipc
+{
+
+struct alloc_stats
+{
+    /**
+     * record sizes (what the record can hold, see get_record_size)
+     * are bucketed by power of two, bucket b is ( 2^(b-1), 2^b ]
+     * bytes, the last bucket takes everything bigger.
+     */
+    static constexpr std::size_t size_buckets   = 32;
+    /** free runs, bucket b is [ 2^b, 2^(b+1) ) bytes **/
+    static constexpr std::size_t run_buckets    = 48;
+
+    static std::size_t size_bucket( const std::size_t bytes )
+    {
+        std::size_t b = 0;
+        while( b < ( size_buckets - 1 ) && ( std::size_t( 1 ) << b ) < bytes )
+        {
+            b++;
+        }
+        return( b );
+    }
+
+    static std::size_t run_bucket( const std::size_t bytes )
+    {
+        std::size_t b = 0;
+        while( b < ( run_buckets - 1 ) && ( std::size_t( 1 ) << ( b + 1 ) ) <= bytes )
+        {
+            b++;
+        }
+        return( b );
+    }
+
+    std::atomic< std::uint64_t >    allocs[ size_buckets ]  = {};
+    std::atomic< std::uint64_t >    frees[ size_buckets ]   = {};
+    /** allocate_record returned nullptr **/
+    std::atomic< std::uint64_t >    failures                = { 0 };
+    /** the heap (every extent) couldn't give a thread what it asked for **/
+    std::atomic< std::uint64_t >    heap_failures           = { 0 };
+    /** 
+     * times a thread had to wait for the alloc semaphore (somebody
+     * else had it) and the time spent waiting.
+     */
+    std::atomic< std::uint64_t >    sem_waits               = { 0 };
+    std::atomic< std::uint64_t >    sem_wait_ns             = { 0 };
+    /** trim scans and what they gave back to the OS, see trim.hpp **/
+    std::atomic< std::uint64_t >    trim_scans              = { 0 };
+    std::atomic< std::uint64_t >    reclaimed_bytes         = { 0 };
+};
+
+/**
+ * local_alloc_stats - a thread's counts that haven't been added to
+ * the buffer's alloc_stats yet.
+ */
+struct local_alloc_stats
+{
+    static constexpr std::uint32_t flush_interval = 1024;
+
+    /** @return true if it's time to flush **/
+    bool count_alloc( const std::size_t bytes )
+    {
+        allocs[ ipc::alloc_stats::size_bucket( bytes ) ]++;
+        return( ++pending >= flush_interval );
+    }
+
+    bool count_free( const std::size_t bytes )
+    {
+        frees[ ipc::alloc_stats::size_bucket( bytes ) ]++;
+        return( ++pending >= flush_interval );
+    }
+
+    bool count_sem_wait( const std::uint64_t ns )
+    {
+        sem_waits++;
+        sem_wait_ns += ns;
+        return( ++pending >= flush_interval );
+    }
+
+    void flush( ipc::alloc_stats &shared )
+    {
+        if( pending == 0 )
+        {
+            return;
+        }
+        for( std::size_t b( 0 ); b < ipc::alloc_stats::size_buckets; b++ )
+        {
+            if( allocs[ b ] != 0 )
+            {
+                shared.allocs[ b ].fetch_add( allocs[ b ], std::memory_order_relaxed );
+                allocs[ b ] = 0;
+            }
+            if( frees[ b ] != 0 )
+            {
+                shared.frees[ b ].fetch_add( frees[ b ], std::memory_order_relaxed );
+                frees[ b ] = 0;
+            }
+        }
+        if( sem_waits != 0 )
+        {
+            shared.sem_waits.fetch_add( sem_waits, std::memory_order_relaxed );
+            shared.sem_wait_ns.fetch_add( sem_wait_ns, std::memory_order_relaxed );
+            sem_waits   = 0;
+            sem_wait_ns = 0;
+        }
+        pending = 0;
+    }
+
+    std::uint64_t   allocs[ ipc::alloc_stats::size_buckets ] = {};
+    std::uint64_t   frees[ ipc::alloc_stats::size_buckets ]  = {};
+    std::uint64_t   sem_waits       = 0;
+    std::uint64_t   sem_wait_ns     = 0;
+    std::uint32_t   pending = 0;
+};
+
+/**
+ * alloc_stats_snapshot - what ipc::buffer::get_stats fills in, sizes
+ * are in bytes, heap figures cover the buffer and every extent.
+ */
+struct alloc_stats_snapshot
+{
+    std::uint64_t   allocs[ ipc::alloc_stats::size_buckets ]    = {};
+    std::uint64_t   frees[ ipc::alloc_stats::size_buckets ]     = {};
+    std::uint64_t   failures            = 0;
+    std::uint64_t   heap_failures       = 0;
+    std::uint64_t   sem_waits           = 0;
+    std::uint64_t   sem_wait_ns         = 0;
+    std::uint64_t   trim_scans          = 0;
+    std::uint64_t   reclaimed_bytes     = 0;
+
+    std::size_t     total_bytes         = 0;
+    std::size_t     free_bytes          = 0;
+    std::size_t     largest_free_run    = 0;
+    /** count of maximal free runs by length, see alloc_stats::run_bucket **/
+    std::uint64_t   free_runs[ ipc::alloc_stats::run_buckets ]  = {};
+
+    /**
+     * fragmentation - share of the free bytes outside the largest free
+     * run, 0 when all the free space is in one piece, near 1 when it's
+     * in crumbs (nullptr with lots free).
+     */
+    double fragmentation() const
+    {
+        return( free_bytes == 0 ? 0.0 :
+                1.0 - ( double( largest_free_run ) / double( free_bytes ) ) );
+    }
+};
+
+} /** end namespace ipc **/
+
+#endif /* END ALLOC_STATS_HPP */
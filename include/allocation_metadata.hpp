@@ -13,6 +13,73 @@
 namespace ipc
 {
 
+/**
+ * alloc_kind - tag written as the first word of any in-block
+ * allocation header so that the free path can figure out what
+ * it is looking at given only the address of a record.
+ */
+enum alloc_kind : std::uint32_t
+{
+    kind_slab   = 0x51ab51ab,
+    kind_record = 0x2ec02d00
+};
+
+/**
+ * record_header - at the front of the first block of every block
+ * allocated record, the record starts right after it. Channels 
+ * still get an allocate_metadata block in front of them given 
+ * the channel structures themselves have to be block aligned.
+ */
+struct alignas( L1D_CACHE_LINE_SIZE ) record_header
+{
+    record_header( const std::size_t       blocks,
+                   const ipc::channel_id_t ch ) : block_count( blocks ),
+                                                  channel( ch ){}
+
+    const ipc::alloc_kind   kind        = ipc::kind_record;
+    /** blocks allocated, including the one we're in **/
+    const std::size_t       block_count = 0;
+    /** channel allocated on, lets the free path find a recycle lane **/
+    const ipc::channel_id_t channel     = ipc::null_channel;
+};
+
+struct inline_header
+{
+    static constexpr std::size_t block_size  = ( 1 << ipc::block_size_power_two );
+    static constexpr std::size_t header_size = sizeof( ipc::record_header );
+
+    /**
+     * has_header - slab and block records both sit past a header at 
+     * the front of their block so they're never block aligned, 
+     * anything that is (channels) has its metadata in the block before.
+     */
+    static bool has_header( const void * const ptr )
+    {
+        return( ( reinterpret_cast< std::uintptr_t >( ptr ) & ( block_size - 1 ) ) != 0 );
+    }
+
+    static void* get_block( void * const ptr )
+    {
+        return( reinterpret_cast< void* >(
+            reinterpret_cast< std::uintptr_t >( ptr ) & ~( block_size - 1 ) ) );
+    }
+
+    static ipc::alloc_kind get_kind( void * const ptr )
+    {
+        return( *reinterpret_cast< ipc::alloc_kind* >( get_block( ptr ) ) );
+    }
+
+    static ipc::record_header* get_header( void * const ptr )
+    {
+        return( reinterpret_cast< ipc::record_header* >( get_block( ptr ) ) );
+    }
+    
+    static void* get_record( ipc::record_header * const header )
+    {
+        return( reinterpret_cast< ipc::byte_t* >( header ) + header_size );
+    }
+};
+
 struct allocate_metadata
 {
 
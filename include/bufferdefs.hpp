@@ -44,10 +44,102 @@
 namespace ipc
 {
     /**
-     * for now we use static buffer and static sizing
+     * block_size_power_two is the base block, everything within the 
+     * data buffer is laid out and addressed in multiples of it. The 
+     * buffer and allocation block sizes are set at runtime with 
+     * buffer_config, these are the defaults and the limits.
      */
-    static constexpr std::uint8_t block_size_power_two = 12; //4KiB
-    static constexpr std::uint8_t buffer_size_pow_two  = 30; //1GiB
+    static constexpr std::uint8_t block_size_power_two     = 12; //4KiB
+    static constexpr std::uint8_t max_block_size_pow_two   = 21; //2MiB
+    static constexpr std::uint8_t buffer_size_pow_two      = 30; //1GiB
+    static constexpr std::uint8_t min_buffer_size_pow_two  = 24; //16MiB
+    static constexpr std::uint8_t max_buffer_size_pow_two  = _IPC_MAX_BUFFER_POW_TWO_;
+    static constexpr std::uint8_t max_extents              = 16;
+
+    static_assert( max_buffer_size_pow_two >= buffer_size_pow_two &&
+                   max_buffer_size_pow_two <= 37,
+                   "MAX_BUFFER_SIZE_POW_TWO must be between 30 and 37" );
+
+    /**
+     * any_numa_node - no placement hint, memory lands wherever the 
+     * kernel puts it. Hints are only acted on if built with USE_NUMA.
+     */
+    static constexpr std::int32_t any_numa_node = -1;
+
+    /**
+     * page_mode - what the data buffer (and its extents) should be 
+     * backed by. page_huge asks the kernel for transparent huge pages
+     * (madvise MADV_HUGEPAGE) in every process that maps the buffer, 
+     * if it says no (THP off for shared memory, or not Linux) the 
+     * buffer just stays on base pages.
+     */
+    enum page_mode : std::uint8_t
+    {
+        page_default = 0,
+        page_huge
+    };
+
+    /**
+     * prefault_mode - how much of the data buffer to fault in when a
+     * process maps it so the first messages don't pay for it. Unlike
+     * the geometry this is per process, page tables are per process
+     * so every attaching process asks for its own.
+     * prefault_none     - first touch faults, the default.
+     * prefault_willneed - madvise MADV_WILLNEED, backs the segment but
+     *                     leaves the page tables to be filled on use.
+     * prefault_populate - madvise MADV_POPULATE_WRITE (Linux 5.14+), 
+     *                     backs and maps every page, falls back to 
+     *                     prefault_touch where the kernel can't.
+     * prefault_touch    - threads touch every page.
+     */
+    enum prefault_mode : std::uint8_t
+    {
+        prefault_none = 0,
+        prefault_willneed,
+        prefault_populate,
+        prefault_touch
+    };
+
+    /**
+     * buffer_config - geometry of the buffer, only the process that
+     * creates the buffer gets to set it, it's recorded in the buffer
+     * itself and everybody attaching after uses that.
+     * buffer_size_pow_two - size of the data buffer, between 
+     *  min_buffer_size_pow_two and max_buffer_size_pow_two.
+     * block_size_pow_two  - smallest unit handed out by the heap,
+     *  between block_size_power_two and max_block_size_pow_two.
+     * growth_extents      - how many extents (see below) the buffer 
+     *  may map when it runs out, zero keeps it at a fixed size.
+     * pages               - see page_mode.
+     * prefault            - see prefault_mode, honored in every process.
+     * prefault_threads    - threads to prefault with, zero uses one
+     *  per hardware thread.
+     * trim_idle_ms        - give free memory back to the OS once it's
+     *  been free this long, checked whenever blocks go back to the 
+     *  heap, zero (the default) leaves it to ipc::buffer::trim.
+     */
+    struct buffer_config
+    {
+        std::uint8_t  buffer_size_pow_two = ipc::buffer_size_pow_two;
+        std::uint8_t  block_size_pow_two  = ipc::block_size_power_two;
+        std::uint8_t  growth_extents      = 0;
+        page_mode     pages               = ipc::page_default;
+        prefault_mode prefault            = ipc::prefault_none;
+        std::uint8_t  prefault_threads    = 0;
+        std::uint32_t trim_idle_ms        = 0;
+
+        constexpr bool valid() const
+        {
+            return( buffer_size_pow_two >= ipc::min_buffer_size_pow_two &&
+                    buffer_size_pow_two <= ipc::max_buffer_size_pow_two &&
+                    block_size_pow_two  >= ipc::block_size_power_two    &&
+                    block_size_pow_two  <= ipc::max_block_size_pow_two  &&
+                    block_size_pow_two  <  buffer_size_pow_two          &&
+                    growth_extents      <  ipc::max_extents             &&
+                    pages               <= ipc::page_huge               &&
+                    prefault            <= ipc::prefault_touch );
+        }
+    };
     
     /** 
      * ptr_offset_t - to represent offsets within 
@@ -60,6 +152,25 @@ namespace ipc
 
 
 
+    /**
+     * extents - once the buffer is full it may map more shared 
+     * memory segments (extents), each the size of the data buffer.
+     * The extent index lives in the high bits of every offset, extent 
+     * zero is the buffer itself so offsets within it don't change. 
+     * Block offsets carry the same index, just shifted down by the
+     * base block size. max_extents counts the buffer itself.
+     */
+    static constexpr std::uint8_t   extent_offset_shift     = 40;
+    static constexpr std::uint8_t   extent_block_shift      = 
+        extent_offset_shift - block_size_power_two;
+    static constexpr ptr_offset_t   extent_offset_mask      = 
+        ( ptr_offset_t( 1 ) << extent_offset_shift ) - 1;
+    static constexpr ptr_offset_t   extent_block_mask       = 
+        ( ptr_offset_t( 1 ) << extent_block_shift ) - 1;
+
+    static_assert( max_buffer_size_pow_two < extent_offset_shift,
+                   "extent index would overlap offsets within the buffer" );
+
     enum ptr_err_t : ptr_offset_t
     {
         invalid_ptr_offset = std::numeric_limits< ptr_offset_t >::min(),
@@ -106,10 +217,8 @@ namespace ipc
              "mpmc_data",
         }};
 
-    using credit_t = std::atomic< std::uint32_t >;
     using ctrl_ptroffset_t = std::atomic< ipc::ptr_offset_t >;
 
-    using wrap_t        = std::atomic< std::uint64_t >;
     /** 
      * might move this one to a separate file, but
      * this one describes the thread id type within
@@ -0,0 +1,45 @@
+/**
+ * ch_arena_spsc.hpp - control block for the optional record arena
+ * of an spsc channel, see spsc_arena.hpp.
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 17:20:51 2026
+ * 
+ * Copyright 2026 Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CH_ARENA_SPSC_HPP
+#define CH_ARENA_SPSC_HPP  1
+#include <cstdint>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+struct alignas( L1D_CACHE_LINE_SIZE ) ch_arena_spsc
+{
+    /** block offset of the arena, invalid if the channel has none **/
+    ipc::ptr_offset_t   base    = ipc::invalid_ptr_offset;
+    /** size of the arena in bytes **/
+    std::uint64_t       bytes   = 0;
+    /**
+     * running byte counts, position in the arena is the count mod 
+     * bytes. Only the producer touches these, the consumer only ever
+     * marks records free.
+     */
+    alignas( L1D_CACHE_LINE_SIZE ) std::uint64_t head = 0;
+    std::uint64_t                                tail = 0;
+};
+
+} /** end namespace ipc **/
+#endif /* END CH_ARENA_SPSC_HPP */
@@ -22,16 +22,26 @@
 
 #include "bufferdefs.hpp"
 #include "padsize.hpp"
+#include <cstdint>
 
 namespace ipc
 {
 
 struct alignas(L1D_CACHE_LINE_SIZE)  ch_ctrl_spsc
 {
-    //these are for the spsc channels 
-    alignas( L1D_CACHE_LINE_SIZE ) ipc::wrap_t                     wrap_head   = {0};
+    /**
+     * these are for the spsc channels, each side's last look at the
+     * other side's index (ch_ctrl_all::data_head/data_tail), only 
+     * re-read when the ring looks full (producer) or empty (consumer).
+     * Each is only ever touched by its own side.
+     */
+    alignas( L1D_CACHE_LINE_SIZE ) std::uint64_t                   cached_head = 0;
+    /** data channels, bytes reserved + 1, zero once committed, producer's **/
+    std::uint64_t                                                  reserved    = 0;
     
-    alignas( L1D_CACHE_LINE_SIZE ) ipc::wrap_t                     wrap_tail   = {0};
+    alignas( L1D_CACHE_LINE_SIZE ) std::uint64_t                   cached_tail = 0;
+    /** data channels, a message is out with peek, consumer's **/
+    std::uint64_t                                                  peeked      = 0;
 
 };
 
@@ -36,6 +36,21 @@ struct alignas( (1<<ipc::block_size_power_two) ) ch_entries_spsc
     static constexpr auto n_entries = 
         ( 1 << ipc::block_size_power_two) / sizeof( ipc::ptr_offset_t );
 
+    /**
+     * ring depth is set per channel, any power of two in this range,
+     * up to n_entries the ring is the front of entry below, anything
+     * deeper is allocated behind the channel.
+     */
+    static constexpr std::size_t min_ring_entries   = 64;
+    static constexpr std::size_t max_ring_entries   = ( 1 << 20 );
+
+    static constexpr bool valid_depth( const std::size_t depth )
+    {
+        return( depth >= min_ring_entries && 
+                depth <= max_ring_entries &&
+                ( depth & ( depth - 1 ) ) == 0 );
+    }
+
     /**
      * now for entries for spsc queue, for now let's just add to all, 
      * even if it does waste an extra 4KiB of space. 
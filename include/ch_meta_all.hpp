@@ -21,7 +21,9 @@
 #define CH_META_ALL_HPP  1
 #include "bufferdefs.hpp"
 #include <cstdint>
+#include <atomic>
 #include "sem.hpp"
+#include "ch_entries_spsc.hpp"
 
 namespace ipc
 {
@@ -40,7 +42,17 @@ struct alignas( L1D_CACHE_LINE_SIZE ) ch_meta_all
     ipc::refcnt_t       ref_count_shd                     = 0; 
 
     ipc::channel_type   type                              = ipc::spsc_record;
+    /** node the channel and its records should live on, see add_channel **/
+    std::atomic< std::int32_t > numa_node                 = { ipc::any_numa_node };
     ipc::sem::sem_key_t channel_semaphore                 = { 0 };
+    /** 
+     * spsc ring, depth - 1, and where the entries are if they 
+     * didn't fit in spsc_q (invalid_ptr_offset if they did), 
+     * set when the channel is created, see ch_entries_spsc. 
+     */
+    std::uint32_t       ring_mask                         = 
+        ipc::ch_entries_spsc::n_entries - 1;
+    ptr_offset_t        ring_base                         = ipc::invalid_ptr_offset;
     /**
      * FIXME - consider making these a union or template dep.
      * vs. extra space, for right now we're eating up an entire 
@@ -48,8 +60,6 @@ struct alignas( L1D_CACHE_LINE_SIZE ) ch_meta_all
      * that'd be nice to optimize.
      */
     alignas( L1D_CACHE_LINE_SIZE ) ptr_offset_t       dummy_node_offset   = ipc::invalid_ptr_offset;
-    alignas( L1D_CACHE_LINE_SIZE ) ipc::credit_t      prod_credits        = 0;
-    alignas( L1D_CACHE_LINE_SIZE ) ipc::credit_t      cons_credits        = 0;
 };
 
 } /** end namespace ipc **/
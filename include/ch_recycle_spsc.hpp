@@ -0,0 +1,83 @@
+/**
+ * ch_recycle_spsc.hpp - reverse lane for an spsc record channel, when
+ * enabled the consumer's free_record hands block records back to the
+ * producer through here instead of the heap, the producer's next
+ * allocate_record of the same size takes them straight back out. 
+ * Single writer (the consumer) and single reader (the producer).
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 18:31:14 2026
+ * 
+ * Copyright 2026 Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CH_RECYCLE_SPSC_HPP
+#define CH_RECYCLE_SPSC_HPP  1
+#include <cstdint>
+#include <atomic>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+struct alignas( L1D_CACHE_LINE_SIZE ) ch_recycle_spsc
+{
+    /** 
+     * small on purpose, it only has to cover the records in flight
+     * between a consumer free and the next producer allocate.
+     */
+    static constexpr std::uint64_t n_entries = 64;
+
+    /**
+     * push - consumer side, hand a record (block offset of its
+     * header) back. 
+     * @return false if the lane is full, caller frees normally.
+     */
+    bool push( const ipc::ptr_offset_t block )
+    {
+        const auto h = head.load( std::memory_order_relaxed );
+        if( h - tail.load( std::memory_order_acquire ) == n_entries )
+        {
+            return( false );
+        }
+        entry[ h % n_entries ] = block;
+        head.store( h + 1, std::memory_order_release );
+        return( true );
+    }
+
+    /**
+     * pop - producer side, take the oldest record handed back.
+     * @return false if the lane is empty.
+     */
+    bool pop( ipc::ptr_offset_t &block )
+    {
+        const auto t = tail.load( std::memory_order_relaxed );
+        if( t == head.load( std::memory_order_acquire ) )
+        {
+            return( false );
+        }
+        block = entry[ t % n_entries ];
+        tail.store( t + 1, std::memory_order_release );
+        return( true );
+    }
+    
+    std::atomic< bool >                                            enabled = { false };
+    /** written by the consumer **/
+    alignas( L1D_CACHE_LINE_SIZE ) std::atomic< std::uint64_t >    head    = { 0 };
+    /** written by the producer **/
+    alignas( L1D_CACHE_LINE_SIZE ) std::atomic< std::uint64_t >    tail    = { 0 };
+    alignas( L1D_CACHE_LINE_SIZE ) ipc::ptr_offset_t               entry[ n_entries ] = { 0 };
+};
+
+} /** end namespace ipc **/
+#endif /* END CH_RECYCLE_SPSC_HPP */
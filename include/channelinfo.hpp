@@ -31,6 +31,8 @@
 #include "ch_ctrl_all.hpp"
 #include "ch_ctrl_spsc.hpp"
 #include "ch_entries_spsc.hpp"
+#include "ch_arena_spsc.hpp"
+#include "ch_recycle_spsc.hpp"
 
 
 
@@ -48,6 +50,8 @@ struct channel_info
     constexpr channel_info( const ipc::channel_id_t ch_id ) : meta( ch_id ),
                                                               ctrl_all(),
                                                               ctrl_spsc(),
+                                                              arena(),
+                                                              recycle(),
                                                               spsc_q() 
     {
 
@@ -57,6 +61,9 @@ struct channel_info
     ipc::ch_meta_all        meta;
     ipc::ch_ctrl_all        ctrl_all;
     ipc::ch_ctrl_spsc       ctrl_spsc;
+    /** ahead of the entries so it fits in the space before them **/
+    ipc::ch_arena_spsc      arena;
+    ipc::ch_recycle_spsc    recycle;
     ipc::ch_entries_spsc    spsc_q; 
 };
 
@@ -0,0 +1,114 @@
+/**
+ * deferred_free.hpp - per thread list of freed block runs that are
+ * too big for the magazine. Instead of taking the alloc semaphore
+ * for each one they're held until either max_records have built
+ * up or the oldest has been waiting max_age, then adjacent runs
+ * are coalesced and the lot goes back to the heap in one locked
+ * pass. Off unless enabled with ipc::buffer::set_deferred_free.
+ *
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 16:40:12 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DEFERRED_FREE_HPP
+#define DEFERRED_FREE_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+/** block offset and length (blocks) of a freed run **/
+using block_run_t = std::pair< ipc::ptr_offset_t, std::size_t >;
+
+struct deferred_free
+{
+    using clock_t = std::chrono::steady_clock;
+
+    bool enabled() const
+    {
+        return( max_records > 0 );
+    }
+
+    void push( const ipc::ptr_offset_t base, const std::size_t blocks )
+    {
+        if( runs.empty() )
+        {
+            oldest = clock_t::now();
+        }
+        runs.emplace_back( base, blocks );
+    }
+
+    /**
+     * due - true if the list should be handed back, checked on
+     * every free so the age bound is only as good as the rate
+     * the thread frees at, close/flush always drains it.
+     */
+    bool due() const
+    {
+        if( runs.empty() )
+        {
+            return( false );
+        }
+        return( runs.size() >= max_records ||
+                ( clock_t::now() - oldest ) >= max_age );
+    }
+
+    /**
+     * coalesce - sort runs by offset and merge any that touch,
+     * runs never merge across extents given the extent index is
+     * in the top bits of the offset.
+     */
+    static void coalesce( std::vector< ipc::block_run_t > &runs )
+    {
+        if( runs.size() < 2 )
+        {
+            return;
+        }
+        std::sort( runs.begin(), runs.end() );
+        std::size_t out = 0;
+        for( std::size_t i( 1 ); i < runs.size(); i++ )
+        {
+            auto &prev = runs[ out ];
+            if( prev.first + static_cast< ipc::ptr_offset_t >( prev.second ) == runs[ i ].first &&
+                ( prev.first  >> ipc::extent_block_shift ) ==
+                ( runs[ i ].first >> ipc::extent_block_shift ) )
+            {
+                prev.second += runs[ i ].second;
+            }
+            else
+            {
+                runs[ ++out ] = runs[ i ];
+            }
+        }
+        runs.resize( out + 1 );
+    }
+
+    std::vector< ipc::block_run_t > runs;
+    /** 0 == disabled, frees go straight to the heap **/
+    std::size_t                     max_records = 0;
+    std::chrono::microseconds       max_age     = std::chrono::microseconds( 0 );
+    clock_t::time_point             oldest;
+};
+
+} /** end namespace ipc **/
+
+#endif /* END DEFERRED_FREE_HPP */
@@ -0,0 +1,71 @@
+/**
+ * extent.hpp - header at the front of each extra shared memory 
+ * segment (extent) a buffer maps once it's out of blocks. Each 
+ * extent has its own heap over its own data, the data starts at
+ * the first base block past the header.
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 16:12:08 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef EXTENT_HPP
+#define EXTENT_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "bufferdefs.hpp"
+#include "meta_info.hpp"
+#include "trim.hpp"
+
+namespace ipc
+{
+
+struct extent_header
+{
+    static constexpr std::uint16_t cookie_in_use = 0x1338;
+
+    /** bytes from the start of the segment to the data **/
+    static constexpr std::size_t header_bytes = 
+        ( ( sizeof( ipc::meta_info::heap_t ) + 
+            sizeof( ipc::trim_map ) +
+            sizeof( std::atomic< std::uint16_t > ) + 
+            ( 1 << ipc::block_size_power_two ) - 1 ) >> ipc::block_size_power_two ) 
+                << ipc::block_size_power_two;
+
+    static void* get_data( extent_header *h )
+    {
+        return( reinterpret_cast< ipc::byte_t* >( h ) + header_bytes );
+    }
+    
+    static extent_header* get_header( void *data )
+    {
+        return( reinterpret_cast< extent_header* >( 
+            reinterpret_cast< ipc::byte_t* >( data ) - header_bytes ) );
+    }
+
+    /** set up by whoever creates the extent, see buffer::add_extent **/
+    ipc::meta_info::heap_t          heap = ipc::meta_info::heap_t( alloc::uninitialized );
+    /** see trim.hpp **/
+    ipc::trim_map                   trim;
+    /** set last by whoever creates the extent **/
+    std::atomic< std::uint16_t >    cookie  = { 0 };
+};
+
+static_assert( sizeof( ipc::extent_header ) <= ipc::extent_header::header_bytes,
+               "extent_header::header_bytes doesn't cover the header" );
+
+} /** end namespace ipc **/
+
+#endif /* END EXTENT_HPP */
@@ -0,0 +1,159 @@
+/**
+ * magazine.hpp - per thread cache of freed block runs. Runs are
+ * grouped by length so that a later allocation of the same size
+ * can pick one straight back up without going through the global
+ * heap (and its semaphore). Once the cache holds more than the
+ * high water mark everything is handed back to the heap under a
+ * single semaphore acquisition.
+ *
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 11:05:31 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef MAGAZINE_HPP
+#define MAGAZINE_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+struct block_magazine
+{
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * most a magazine will hold before flushing to the global heap
+     * (4MiB with 4KiB blocks), smaller buffers get less, see set_limit.
+     */
+    static constexpr std::size_t default_high_water_blocks  = ( 1 << 10 );
+    static constexpr std::size_t min_high_water_blocks      = ( 1 << 4 );
+    /** one thread's magazine holds at most 1/64th of the buffer **/
+    static constexpr std::size_t buffer_share_shift         = 6;
+    /** frees between looks at the clock, see idle **/
+    static constexpr std::uint32_t idle_check_interval      = 32;
+
+    /**
+     * set_limit - size the high water mark for a buffer of 
+     * buffer_blocks (base) blocks, every thread caches up to this
+     * much and only its own allocations can use it.
+     */
+    void set_limit( const std::size_t buffer_blocks )
+    {
+        high_water_blocks = 
+            std::min( default_high_water_blocks,
+                      std::max( min_high_water_blocks, buffer_blocks >> buffer_share_shift ) );
+        max_run_blocks    = ( high_water_blocks >> 2 );
+    }
+
+    /**
+     * push - cache a run of blocks.
+     * @return false if the run is too large to cache, caller
+     * should return it to the heap directly.
+     */
+    bool push( const ipc::ptr_offset_t base, const std::size_t blocks )
+    {
+        if( blocks > max_run_blocks )
+        {
+            return( false );
+        }
+        runs[ blocks ].push_back( base );
+        cached_blocks += blocks;
+        return( true );
+    }
+
+    /**
+     * pop - take a cached run of exactly blocks.
+     * @return false if nothing of that size is cached.
+     */
+    bool pop( const std::size_t blocks, ipc::ptr_offset_t &base )
+    {
+        auto found = runs.find( blocks );
+        if( found == runs.end() || (*found).second.empty() )
+        {
+            return( false );
+        }
+        base = (*found).second.back();
+        (*found).second.pop_back();
+        cached_blocks -= blocks;
+        drawn = true;
+        return( true );
+    }
+
+    bool over_high_water() const
+    {
+        return( cached_blocks > high_water_blocks );
+    }
+
+    /**
+     * idle - true if runs have sat here for max_idle without this 
+     * thread taking any back out (it only frees, a consumer say), so
+     * they should go back where others can get at them. Only looks at
+     * the clock every idle_check_interval frees, like deferred_free::due
+     * it's only as good as the rate the thread frees at, close always
+     * drains it.
+     */
+    bool idle()
+    {
+        if( ++frees < idle_check_interval )
+        {
+            return( false );
+        }
+        frees = 0;
+        const auto now = clock_t::now();
+        if( drawn || empty() )
+        {
+            drawn       = false;
+            idle_since  = now;
+            return( false );
+        }
+        if( ( now - idle_since ) < max_idle )
+        {
+            return( false );
+        }
+        /** a thread that only frees hands back at most once per max_idle **/
+        idle_since = now;
+        return( true );
+    }
+
+    bool empty() const
+    {
+        return( cached_blocks == 0 );
+    }
+
+    /** run length (blocks) -> block offsets of cached runs **/
+    std::map< std::size_t, std::vector< ipc::ptr_offset_t > > runs;
+    std::size_t cached_blocks = 0;
+
+    /** see set_limit, runs longer than max_run_blocks aren't worth caching **/
+    std::size_t high_water_blocks   = default_high_water_blocks;
+    std::size_t max_run_blocks      = ( default_high_water_blocks >> 2 );
+
+    std::chrono::microseconds   max_idle    = std::chrono::milliseconds( 10 );
+    clock_t::time_point         idle_since  = clock_t::now();
+    std::uint32_t               frees       = 0;
+    /** something was popped since the last look at the clock **/
+    bool                        drawn       = false;
+};
+
+} /** end namespace ipc **/
+
+#endif /* END MAGAZINE_HPP */
@@ -24,13 +24,18 @@
 #include <cstdint>
 #include "bufferdefs.hpp"
 #include "allocheap.hpp"
+#include "alloc_stats.hpp"
+#include "trim.hpp"
 #include "translate.hpp"
 #include "lock_ll.hpp"
 #include "mpmc_lock_free.hpp"
 #include "spsc_lock_free.hpp"
+#include "spsc_data.hpp"
+#include "spsc_arena.hpp"
 #include "shared_seg.hpp"
 #include "channelindex.hpp"
 #include "recordindex.hpp"
+#include "shm_module.hpp"
 
 
 namespace ipc
@@ -46,7 +51,25 @@ private:
 
 public:
     
-    using heap_t            = alloc::heap< buffer_size_pow_two, block_size_power_two >;
+    /**
+     * the heap is sized for the largest buffer at the smallest block 
+     * size, initialize only turns on the part this buffer actually 
+     * has. Heap blocks are allocation blocks (see buffer_config), 
+     * not base blocks.
+     */
+#if _USE_LOCK_FREE_HEAP_ == 1
+    using heap_t            = alloc::heap< max_buffer_size_pow_two, 
+                                           block_size_power_two, 
+                                           alloc::lock_free >;
+#elif _USE_BUDDY_HEAP_ == 1
+    using heap_t            = alloc::heap< max_buffer_size_pow_two, 
+                                           block_size_power_two, 
+                                           alloc::buddy >;
+#else
+    using heap_t            = alloc::heap< max_buffer_size_pow_two, 
+                                           block_size_power_two, 
+                                           alloc::locked >;
+#endif
     using channel_list_t    = lock_ll< channel_index_t, translate_helper >;
     using mpmc_lock_free    = ipc::mpmc_lock_free_queue< ipc::channel_info,
                                                          ipc::record_index_t, 
@@ -55,13 +78,16 @@ public:
     using spsc_lock_free    = ipc::spsc_lock_free_queue< ipc::channel_info,
                                                          void,
                                                          translate_helper >;
+    using spsc_data         = ipc::spsc_data_queue< ipc::channel_info,
+                                                    translate_helper >;
     using shm_seg           = ipc::shared_seg< ipc::channel_info /**reuse spsc**/, 
                                                translate_helper >;
     
     meta_info()     = default;
     ~meta_info()    = default;
 
-    heap_t                        heap;
+    /** buffer::initialize sets it up once it knows the size **/
+    heap_t                        heap = heap_t( alloc::uninitialized );
     channel_list_t                channel_list;
 
     ipc::sem::sem_key_t           index_sem_name;
@@ -78,6 +104,33 @@ public:
      * buffer_size - databuffer size by itself. 
      */
     std::size_t             databuffer_size         = 0;
+
+    /**
+     * geometry set by the creator, see buffer_config, attaching
+     * processes go by these, never by what they asked for.
+     */
+    std::uint8_t            buffer_size_pow_two     = ipc::buffer_size_pow_two;
+    std::uint8_t            block_size_pow_two      = ipc::block_size_power_two;
+    ipc::page_mode          pages                   = ipc::page_default;
+
+    /**
+     * extents - extra segments mapped once the buffer is full, see
+     * extent.hpp. extent_count includes the buffer itself, so it 
+     * starts at one and only ever grows, the key for an extent is
+     * written before the count is bumped past it.
+     */
+    std::uint8_t                    extent_limit    = 1;
+    std::atomic< std::uint8_t >     extent_count    = { 1 };
+    shm_key_t                       extent_keys[ ipc::max_extents ];
+
+    /** see alloc_stats.hpp, read with ipc::buffer::get_stats **/
+    ipc::alloc_stats                stats;
+
+    /** see trim.hpp and ipc::buffer::trim **/
+    ipc::trim_state                 trim_info;
+
+    /** every channel arena, see spsc_arena.hpp **/
+    ipc::arena_map                  arenas;
     
     /**
      * ordering here matters, this will be
@@ -0,0 +1,63 @@
+/**
+ * prefault.hpp - what ipc::buffer::prefault did, and how far along
+ * it is while it's doing it. Pass one to ipc::buffer::initialize or
+ * ipc::buffer::prefault, set progress if you want to hear about it
+ * as it goes, everything else is filled in.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 10:05:41 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PREFAULT_HPP
+#define PREFAULT_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+struct prefault_report
+{
+    /**
+     * progress_t - called from the thread that asked for the prefault
+     * each time it finishes a chunk (see chunk_bytes) and once more at
+     * the end, bytes_done only ever goes up.
+     */
+    using progress_t = void (*)( const ipc::prefault_report &report, void *ctx );
+
+    /** work is handed out to the prefault threads in chunks this big **/
+    static constexpr std::size_t chunk_bytes = ( 1 << 21 );
+
+    /** set by the caller, both optional **/
+    progress_t                  progress    = nullptr;
+    void                        *ctx        = nullptr;
+
+    /**
+     * mode actually used, differs from what was asked for if the
+     * kernel wouldn't populate and we had to touch instead.
+     */
+    ipc::prefault_mode          mode        = ipc::prefault_none;
+    std::uint8_t                threads     = 0;
+    std::size_t                 bytes_total = 0;
+    std::size_t                 bytes_done  = 0;
+    std::chrono::microseconds   elapsed     = std::chrono::microseconds( 0 );
+};
+
+} /** end namespace ipc **/
+
+#endif /* END PREFAULT_HPP */
@@ -0,0 +1,88 @@
+/**
+ * refill_policy.hpp - how big a channel's next thread local run is.
+ * Each channel starts out asking the heap for min_bytes at a time,
+ * if it comes back for more within grow_interval of the last refill
+ * the size doubles (up to max_bytes), if it takes longer than
+ * shrink_interval it halves (down to min_bytes). A refill is always
+ * big enough for records_per_refill of the record that caused it. So
+ * a channel that sends a few records a second sits on min_bytes, a
+ * fast producer works its way up to max_bytes and stops coming back
+ * to the heap every handful of records.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 16:37:20 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef REFILL_POLICY_HPP
+#define REFILL_POLICY_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <algorithm>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+struct refill_policy
+{
+    using clock_t = std::chrono::steady_clock;
+
+    static constexpr std::size_t    min_bytes           = ( 1 << 16 );
+    static constexpr std::size_t    max_bytes           = ( 1 << 23 );
+    static constexpr std::size_t    records_per_refill  = 3;
+
+    static constexpr std::chrono::microseconds grow_interval   =
+        std::chrono::microseconds( 1000 );
+    static constexpr std::chrono::microseconds shrink_interval =
+        std::chrono::microseconds( 100000 );
+
+    static constexpr std::size_t    min_blocks = ( min_bytes >> ipc::block_size_power_two );
+    static constexpr std::size_t    max_blocks = ( max_bytes >> ipc::block_size_power_two );
+
+    /**
+     * next - blocks to ask the heap for, blocks is what the caller
+     * needs right now, moves target along per the schedule above.
+     * @return blocks to ask for, never less than blocks
+     */
+    std::size_t next( const std::size_t blocks )
+    {
+        const auto now = clock_t::now();
+        if( refills > 0 )
+        {
+            const auto interval = now - last;
+            if( interval < grow_interval )
+            {
+                target = std::min( target << 1, max_blocks );
+            }
+            else if( interval > shrink_interval )
+            {
+                target = std::max( target >> 1, min_blocks );
+            }
+        }
+        last = now;
+        refills++;
+        return( std::max( target, blocks * records_per_refill ) );
+    }
+
+    std::size_t             target  = min_blocks;
+    std::uint64_t           refills = 0;
+    clock_t::time_point     last;
+};
+
+} /** end namespace ipc **/
+
+#endif /* END REFILL_POLICY_HPP */
@@ -218,6 +218,14 @@ static int final_close( ipc::sem::sem_key_t key );
  */
 static int wait( ipc::sem::sem_obj_t key ); 
 
+/**
+ * try_wait - take the given semaphore if it's free right now
+ * @param key - valid sem_obj_t
+ * @return - (0) if taken, (-1) otherwise, errno is EAGAIN if 
+ * somebody else just has it.
+ */
+static int try_wait( ipc::sem::sem_obj_t key );
+
 /**
  * post - post on the given semaphore
  * @param key - valid sem_obj_t
@@ -0,0 +1,151 @@
+/**
+ * slab.hpp - size class sub-allocator for small records. Each slab is
+ * a single block taken from the thread local allocation, with a compact
+ * header at the start of the block and as many records of a single size
+ * class packed behind it as will fit. Records within a slab are never
+ * block aligned (the header always sits at the front) which is how the
+ * free path tells a slab record from a normal block record.
+ *
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 09:12:44 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SLAB_HPP
+#define SLAB_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "bufferdefs.hpp"
+#include "allocation_metadata.hpp"
+
+namespace ipc
+{
+
+struct alignas( L1D_CACHE_LINE_SIZE ) slab_header
+{
+    slab_header( const std::uint16_t size,
+                 const std::uint16_t cap ) : record_size( size ),
+                                             capacity( cap ){}
+
+    /**
+     * set in the live count if the owning thread has
+     * moved on to another slab, whoever drops the live
+     * count to zero after this is set returns the block.
+     */
+    static constexpr std::uint32_t detached = (1U << 31);
+
+    const ipc::alloc_kind       kind            = ipc::kind_slab;
+    const std::uint16_t         record_size     = 0;
+    const std::uint16_t         capacity        = 0;
+    /** live record count | detached bit **/
+    std::atomic< std::uint32_t >  state         = { 0 };
+};
+
+/**
+ * slab_cursor - per thread, per channel, per size class state,
+ * kept within the TLS so that the owning thread can bump allocate
+ * without touching anything shared except the live count.
+ */
+struct slab_cursor
+{
+    /** block offset of the current slab **/
+    ipc::ptr_offset_t   block   = ipc::invalid_ptr_offset;
+    /** next free record index within the slab **/
+    std::uint16_t       next    = 0;
+};
+
+struct slab
+{
+    slab()  = delete;
+    ~slab() = delete;
+
+    static constexpr std::size_t block_size  = ( 1 << ipc::block_size_power_two );
+    static constexpr std::size_t header_size = sizeof( ipc::slab_header );
+
+    /**
+     * size classes are powers of two from 8B up, the top class is
+     * whatever gives exactly two records per block once the header
+     * is accounted for (2016B with a 4KiB block and 64B header).
+     */
+    static constexpr std::size_t min_size_pow_two = 3;
+    static constexpr std::size_t n_classes        = 9;
+    static constexpr std::size_t max_record_size  =
+        ( ( block_size - header_size ) / 2 ) & ~std::size_t( 7 );
+
+    static_assert( max_record_size >= ( 1 << ( min_size_pow_two + n_classes - 2 ) ),
+                   "top slab class must be larger than the largest power of two class" );
+
+    /**
+     * size_class - return the class index for a request of nbytes,
+     * caller must check nbytes <= max_record_size first.
+     */
+    static constexpr std::size_t size_class( const std::size_t nbytes )
+    {
+        std::size_t cls = 0;
+        while( cls < ( n_classes - 1 ) &&
+               ( std::size_t( 1 ) << ( cls + min_size_pow_two ) ) < nbytes )
+        {
+            cls++;
+        }
+        return( cls );
+    }
+
+    static constexpr std::size_t class_size( const std::size_t cls )
+    {
+        return( cls == ( n_classes - 1 ) ? max_record_size :
+                                           std::size_t( 1 ) << ( cls + min_size_pow_two ) );
+    }
+
+    static constexpr std::size_t class_capacity( const std::size_t cls )
+    {
+        return( ( block_size - header_size ) / class_size( cls ) );
+    }
+
+    /**
+     * is_slab_record - records handed out by the slab are never
+     * aligned to a block boundary, neither are block records with
+     * an inline header, so check the tag too.
+     */
+    static bool is_slab_record( void * const ptr )
+    {
+        return( ipc::inline_header::has_header( ptr ) && 
+                ipc::inline_header::get_kind( ptr ) == ipc::kind_slab );
+    }
+
+    /**
+     * get_header - given a record address in the callers VA space,
+     * return the slab header in the same VA space.
+     */
+    static ipc::slab_header* get_header( void * const ptr )
+    {
+        return( reinterpret_cast< ipc::slab_header* >(
+            reinterpret_cast< std::uintptr_t >( ptr ) & ~( block_size - 1 ) ) );
+    }
+
+    /**
+     * get_record - return record at index within slab.
+     */
+    static void* get_record( ipc::slab_header * const header,
+                             const std::size_t index )
+    {
+        return( reinterpret_cast< ipc::byte_t* >( header ) + header_size +
+                    ( index * header->record_size ) );
+    }
+};
+
+} /** end namespace ipc **/
+
+#endif /* END SLAB_HPP */
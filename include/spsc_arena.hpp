@@ -0,0 +1,240 @@
+/**
+ * spsc_arena.hpp - circular arena for the records of a single spsc
+ * channel. Records on these channels are almost always freed in the
+ * order they were sent so the producer just bumps a head through a 
+ * ring of bytes owned by the channel. Frees only mark the record
+ * header, the producer moves the tail over freed records when it 
+ * needs room, so frees can come from any thread and in any order
+ * without a lock (an out of order free just holds up the tail until
+ * the ones before it are freed). Neither side touches the heap or 
+ * the alloc semaphore once the channel is set up.
+ *
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 17:24:09 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SPSC_ARENA_HPP
+#define SPSC_ARENA_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <cassert>
+#include "bufferdefs.hpp"
+#include "ch_arena_spsc.hpp"
+
+namespace ipc
+{
+
+struct arena_record_header
+{
+    static constexpr std::uint32_t live = 0xa2e7a11e;
+    static constexpr std::uint32_t free = 0xa2e7a0ff;
+
+    /** bytes taken in the arena, header and padding included **/
+    std::uint32_t                   bytes = 0;
+    std::atomic< std::uint32_t >    state = { free };
+    std::uint64_t                   pad   = 0;
+};
+
+/**
+ * arena_map - block ranges of every channel arena, kept in the buffer
+ * itself so the free path can tell an arena record from everything
+ * else from any thread (or process), whether or not it has the 
+ * channel open. Slots are only claimed and given back with the index
+ * semaphore held (channel create/remove), lookups take no lock.
+ */
+struct arena_map
+{
+    static constexpr std::size_t max_arenas = 64;
+
+    struct slot
+    {
+        /** first block of the arena, invalid if the slot is open **/
+        std::atomic< ipc::ptr_offset_t >    begin   = { ipc::invalid_ptr_offset };
+        /** one past the last block **/
+        std::atomic< ipc::ptr_offset_t >    end     = { ipc::invalid_ptr_offset };
+    };
+
+    /** slots at or past this have never been used **/
+    std::atomic< std::uint32_t >    used = { 0 };
+    slot                            slots[ max_arenas ];
+
+    bool has_room() const
+    {
+        return( find_slot( ipc::invalid_ptr_offset ) != max_arenas ||
+                used.load( std::memory_order_relaxed ) < max_arenas );
+    }
+
+    /** add - index semaphore held, caller checked has_room **/
+    void add( const ipc::ptr_offset_t begin, const std::size_t blocks )
+    {
+        auto index = find_slot( ipc::invalid_ptr_offset );
+        if( index == max_arenas )
+        {
+            index = used.load( std::memory_order_relaxed );
+            assert( index < max_arenas );
+        }
+        slots[ index ].end.store( begin + blocks, std::memory_order_relaxed );
+        /** release, end is there before anybody can match begin **/
+        slots[ index ].begin.store( begin, std::memory_order_release );
+        if( index == used.load( std::memory_order_relaxed ) )
+        {
+            used.store( index + 1, std::memory_order_release );
+        }
+    }
+
+    /** remove - index semaphore held, arena is about to be freed **/
+    void remove( const ipc::ptr_offset_t begin )
+    {
+        const auto index = find_slot( begin );
+        if( index != max_arenas )
+        {
+            slots[ index ].begin.store( ipc::invalid_ptr_offset, std::memory_order_release );
+        }
+    }
+
+    bool contains( const ipc::ptr_offset_t block ) const
+    {
+        const auto n = used.load( std::memory_order_acquire );
+        for( std::uint32_t i( 0 ); i < n; i++ )
+        {
+            const auto begin = slots[ i ].begin.load( std::memory_order_acquire );
+            if( begin != ipc::invalid_ptr_offset && block >= begin && 
+                block < slots[ i ].end.load( std::memory_order_relaxed ) )
+            {
+                return( true );
+            }
+        }
+        return( false );
+    }
+
+private:
+    std::uint32_t find_slot( const ipc::ptr_offset_t begin ) const
+    {
+        const auto n = used.load( std::memory_order_relaxed );
+        for( std::uint32_t i( 0 ); i < n; i++ )
+        {
+            if( slots[ i ].begin.load( std::memory_order_relaxed ) == begin )
+            {
+                return( i );
+            }
+        }
+        return( max_arenas );
+    }
+};
+
+struct spsc_arena
+{
+    spsc_arena()  = delete;
+    ~spsc_arena() = delete;
+
+    static constexpr std::size_t header_size    = sizeof( ipc::arena_record_header );
+    /** records are cache line granular so producer and consumer don't share lines **/
+    static constexpr std::size_t record_align   = L1D_CACHE_LINE_SIZE;
+
+    static_assert( header_size < record_align, "arena header must fit in a cache line" );
+
+    /**
+     * allocate - producer side, carve nbytes out of the arena.
+     * @return record or nullptr if the arena doesn't have room, 
+     * caller should fall back to the heap.
+     */
+    static void* allocate( ipc::ch_arena_spsc *ctrl,
+                           ipc::byte_t        *base,
+                           const std::size_t  nbytes )
+    {
+        const std::uint64_t need = 
+            ( nbytes + header_size + record_align - 1 ) & ~std::uint64_t( record_align - 1 );
+        /** anything over half the arena would stall the ring, heap is better **/
+        if( need > ( ctrl->bytes >> 1 ) )
+        {
+            return( nullptr );
+        }
+        auto pos = ctrl->head % ctrl->bytes;
+        /** records don't wrap, pad out to the end of the arena instead **/
+        const std::uint64_t pad = ( pos + need > ctrl->bytes ? ctrl->bytes - pos : 0 );
+        if( space( ctrl ) < pad + need )
+        {
+            reclaim( ctrl, base );
+            if( space( ctrl ) < pad + need )
+            {
+                return( nullptr );
+            }
+        }
+        if( pad != 0 )
+        {
+            auto *filler = new ( base + pos ) ipc::arena_record_header();
+            filler->bytes = pad;
+            ctrl->head += pad;
+            pos = 0;
+        }
+        auto *header = new ( base + pos ) ipc::arena_record_header();
+        header->bytes = need;
+        header->state.store( ipc::arena_record_header::live, std::memory_order_relaxed );
+        ctrl->head += need;
+        return( base + pos + header_size );
+    }
+
+    /**
+     * release - mark the record free, safe from any thread, the 
+     * producer picks it up the next time it needs room.
+     */
+    static void release( void * const record )
+    {
+        auto *header = get_header( record );
+        assert( header->state.load( std::memory_order_relaxed ) == ipc::arena_record_header::live );
+        header->state.store( ipc::arena_record_header::free, std::memory_order_release );
+    }
+
+    static std::size_t get_record_size( void * const record )
+    {
+        return( get_header( record )->bytes - header_size );
+    }
+
+    static std::uint64_t space( const ipc::ch_arena_spsc *ctrl )
+    {
+        return( ctrl->bytes - ( ctrl->head - ctrl->tail ) );
+    }
+
+    /**
+     * reclaim - producer side, move the tail over every record that 
+     * has been freed, stops at the first one still live.
+     */
+    static void reclaim( ipc::ch_arena_spsc *ctrl, ipc::byte_t *base )
+    {
+        while( ctrl->tail != ctrl->head )
+        {
+            auto *header = reinterpret_cast< ipc::arena_record_header* >( 
+                base + ( ctrl->tail % ctrl->bytes ) );
+            if( header->state.load( std::memory_order_acquire ) != ipc::arena_record_header::free )
+            {
+                break;
+            }
+            ctrl->tail += header->bytes;
+        }
+    }
+
+private:
+    static ipc::arena_record_header* get_header( void * const record )
+    {
+        return( reinterpret_cast< ipc::arena_record_header* >( 
+            reinterpret_cast< ipc::byte_t* >( record ) - header_size ) );
+    }
+};
+
+} /** end namespace ipc **/
+
+#endif /* END SPSC_ARENA_HPP */
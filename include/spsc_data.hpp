@@ -0,0 +1,262 @@
+/**
+ * spsc_data.hpp - single producer, single consumer byte ring for the
+ * spsc_data channels. Messages are copied straight into the ring, which
+ * lives in the channel's own blocks (meta.ring_base), as frames of a
+ * data_frame header and the payload rounded up to frame_align bytes.
+ * A frame never straddles the end of the ring, if it won't fit the
+ * producer fills the rest with a skip frame and starts over at the
+ * front. Head and tail count bytes, see spsc_index. reserve/commit
+ * and peek/release hand out the frames in place, push/pop copy.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 22:31:40 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SPSC_DATA_HPP
+#define SPSC_DATA_HPP  1
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <limits>
+#include "bufferdefs.hpp"
+#include "spsc_index.hpp"
+
+namespace ipc
+{
+
+struct data_frame
+{
+    /** payload bytes, or skip for the filler at the end of the ring **/
+    std::uint32_t   length  = 0;
+    std::uint32_t   pad     = 0;
+
+    static constexpr std::uint32_t skip = std::numeric_limits< std::uint32_t >::max();
+};
+
+template < class PARENTNODE, class TRANSLATE >
+    class spsc_data_queue : public spsc_index< PARENTNODE >
+{
+private:
+
+    spsc_data_queue() = delete;
+
+    using self_t = spsc_data_queue< PARENTNODE, TRANSLATE >;
+
+    inline static ipc::byte_t* ring( PARENTNODE *channel, void *buffer_base )
+    {
+        return( (ipc::byte_t*) TRANSLATE::translate_block( buffer_base,
+                                                           channel->meta.ring_base ) );
+    }
+
+public:
+
+    static constexpr std::size_t    frame_align         = sizeof( ipc::data_frame );
+    static constexpr std::size_t    header_bytes        = sizeof( ipc::data_frame );
+    /** ring sizes, any power of two in range, set when the channel is made **/
+    static constexpr std::size_t    default_ring_bytes  = ( 1 << 16 );
+    static constexpr std::size_t    min_ring_bytes      = ( 1 << ipc::block_size_power_two );
+    static constexpr std::size_t    max_ring_bytes      = ( 1 << 30 );
+
+    static constexpr bool valid_ring_bytes( const std::size_t bytes )
+    {
+        return( bytes >= min_ring_bytes &&
+                bytes <= max_ring_bytes &&
+                ( bytes & ( bytes - 1 ) ) == 0 );
+    }
+
+    /** frame_bytes - ring bytes a message of length bytes takes **/
+    static constexpr std::size_t frame_bytes( const std::size_t length )
+    {
+        return( header_bytes + ( ( length + frame_align - 1 ) & ~( frame_align - 1 ) ) );
+    }
+
+    /** max_message - biggest message the channel will ever take **/
+    inline static std::size_t max_message( PARENTNODE *channel )
+    {
+        return( self_t::depth( channel ) - header_bytes );
+    }
+
+    /**
+     * reserve - room for a length byte message at the tail, skipping
+     * to the front of the ring if it won't fit before the end. Nothing
+     * is visible to the consumer until commit, a reserve that's never
+     * committed is just forgotten by the next one, so is one that
+     * comes back nullptr (a filler it wrote moved the tail).
+     * @return - where the payload goes, nullptr if there isn't room
+     * right now (or ever, check max_message).
+     */
+    static void* reserve( PARENTNODE *channel,
+                          const std::size_t length,
+                          void *buffer_base )
+    {
+        /** whatever was reserved before is gone, even if this one fails **/
+        channel->ctrl_spsc.reserved = 0;
+        const auto frame    = self_t::frame_bytes( length );
+        if( frame > self_t::depth( channel ) )
+        {
+            return( nullptr );
+        }
+        const auto mask     = channel->meta.ring_mask;
+        auto *base          = self_t::ring( channel, buffer_base );
+        auto tail           = self_t::load_tail( channel, std::memory_order_relaxed );
+        const auto till_end = self_t::depth( channel ) - ( tail & mask );
+        if( frame > till_end )
+        {
+            if( self_t::producer_room( channel, tail, till_end ) < till_end )
+            {
+                return( nullptr );
+            }
+            /** the filler can go now, the consumer just steps over it **/
+            auto *filler = reinterpret_cast< ipc::data_frame* >( base + ( tail & mask ) );
+            filler->length = ipc::data_frame::skip;
+            tail += till_end;
+            channel->ctrl_all.data_tail.store( tail, std::memory_order_release );
+        }
+        if( self_t::producer_room( channel, tail, frame ) < frame )
+        {
+            return( nullptr );
+        }
+        /** plus one, zero is no reserve **/
+        channel->ctrl_spsc.reserved = length + 1;
+        return( base + ( tail & mask ) + header_bytes );
+    }
+
+    /**
+     * commit - publish the message at the tail.
+     * @return - false if length is more than the reserve before it
+     * (or there wasn't one), nothing is published.
+     */
+    static bool commit( PARENTNODE *channel,
+                        const std::size_t length,
+                        void *buffer_base )
+    {
+        auto &reserved = channel->ctrl_spsc.reserved;
+        if( length >= reserved )
+        {
+            return( false );
+        }
+        reserved = 0;
+        const auto tail = self_t::load_tail( channel, std::memory_order_relaxed );
+        auto *frame     = reinterpret_cast< ipc::data_frame* >(
+            self_t::ring( channel, buffer_base ) + ( tail & channel->meta.ring_mask ) );
+        frame->length   = std::uint32_t( length );
+        /** release, payload and header are visible before the tail moves **/
+        channel->ctrl_all.data_tail.store( tail + self_t::frame_bytes( length ),
+                                           std::memory_order_release );
+        return( true );
+    }
+
+    /**
+     * peek - the message at the head, in place, stepping over any
+     * filler on the way.
+     * @param length - set to the payload length
+     * @return - the payload, nullptr if there's nothing.
+     */
+    static const void* peek( PARENTNODE *channel,
+                             std::size_t &length,
+                             void *buffer_base )
+    {
+        const auto mask = channel->meta.ring_mask;
+        auto *base      = self_t::ring( channel, buffer_base );
+        auto head       = self_t::load_head( channel, std::memory_order_relaxed );
+        /** frames are published whole, a header means a whole frame **/
+        while( self_t::consumer_avail( channel, head, header_bytes ) != 0 )
+        {
+            const auto *frame = reinterpret_cast< ipc::data_frame* >( base + ( head & mask ) );
+            if( frame->length != ipc::data_frame::skip )
+            {
+                channel->ctrl_spsc.peeked = 1;
+                length = frame->length;
+                return( frame + 1 );
+            }
+            head += self_t::depth( channel ) - ( head & mask );
+            channel->ctrl_all.data_head.store( head, std::memory_order_release );
+        }
+        return( nullptr );
+    }
+
+    /**
+     * release - done with the message peek returned, the producer can
+     * have its bytes back.
+     * @return - false if there wasn't a peek first.
+     */
+    static bool release( PARENTNODE *channel, void *buffer_base )
+    {
+        auto &peeked = channel->ctrl_spsc.peeked;
+        if( peeked == 0 )
+        {
+            return( false );
+        }
+        peeked = 0;
+        const auto head     = self_t::load_head( channel, std::memory_order_relaxed );
+        const auto *frame   = reinterpret_cast< ipc::data_frame* >(
+            self_t::ring( channel, buffer_base ) + ( head & channel->meta.ring_mask ) );
+        /** release, the payload is read before the producer writes over it **/
+        channel->ctrl_all.data_head.store( head + self_t::frame_bytes( frame->length ),
+                                           std::memory_order_release );
+        return( true );
+    }
+
+    /**
+     * push - copy length bytes in as one message.
+     * @return - tx_success, tx_retry if the ring is full right now.
+     */
+    static ipc::tx_code push( PARENTNODE *channel,
+                              const void *bytes,
+                              const std::size_t length,
+                              void *buffer_base )
+    {
+        auto *payload = self_t::reserve( channel, length, buffer_base );
+        if( payload == nullptr )
+        {
+            return( ipc::tx_retry );
+        }
+        std::memcpy( payload, bytes, length );
+        self_t::commit( channel, length, buffer_base );
+        return( ipc::tx_success );
+    }
+
+    /**
+     * pop - copy the message at the head out to bytes.
+     * @param length - set to the message length, even if it didn't fit
+     * @return - tx_success, tx_retry if there's nothing, tx_error if
+     * capacity is too small (the message stays put).
+     */
+    static ipc::tx_code pop( PARENTNODE *channel,
+                             void *bytes,
+                             const std::size_t capacity,
+                             std::size_t &length,
+                             void *buffer_base )
+    {
+        const auto *payload = self_t::peek( channel, length, buffer_base );
+        if( payload == nullptr )
+        {
+            return( ipc::tx_retry );
+        }
+        if( length > capacity )
+        {
+            return( ipc::tx_error );
+        }
+        std::memcpy( bytes, payload, length );
+        self_t::release( channel, buffer_base );
+        return( ipc::tx_success );
+    }
+}; /** end class spsc_data_queue **/
+
+} /** end namespace ipc **/
+
+#endif /* END SPSC_DATA_HPP */
@@ -0,0 +1,128 @@
+/**
+ * spsc_index.hpp - head/tail bookkeeping shared by the single producer,
+ * single consumer rings (spsc_lock_free_queue, spsc_data_queue).
+ * ch_ctrl_all::data_head/data_tail are free running 64-bit counts of
+ * units (entries or bytes) consumed/produced, they never wrap in
+ * practice, the position in the ring is the count & ring_mask and the
+ * fill is tail - head. Each side keeps a copy of the other's index in
+ * ch_ctrl_spsc and only goes to the other side's cache line when that
+ * copy says full/empty.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 22:17:05 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SPSC_INDEX_HPP
+#define SPSC_INDEX_HPP  1
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+
+namespace ipc
+{
+
+template < class PARENTNODE > class spsc_index
+{
+public:
+
+    spsc_index() = delete;
+
+    /** depth - units in the ring, ring_mask + 1 **/
+    inline static std::size_t depth( PARENTNODE *channel )
+    {
+        return( std::size_t( channel->meta.ring_mask ) + 1 );
+    }
+
+    inline static std::uint64_t load_head( PARENTNODE *channel,
+                                           const std::memory_order order )
+    {
+        return( static_cast< std::uint64_t >( channel->ctrl_all.data_head.load( order ) ) );
+    }
+
+    inline static std::uint64_t load_tail( PARENTNODE *channel,
+                                           const std::memory_order order )
+    {
+        return( static_cast< std::uint64_t >( channel->ctrl_all.data_tail.load( order ) ) );
+    }
+
+    /**
+     * size - units in the ring right now, from anybody's point of
+     * view. Head first, it can only move toward the tail, so the
+     * difference is never negative, it can be stale high if the
+     * producer got in between the two loads though, hence the min.
+     */
+    inline static std::size_t size( PARENTNODE *channel )
+    {
+        const auto head = load_head( channel, std::memory_order_acquire );
+        const auto tail = load_tail( channel, std::memory_order_acquire );
+        return( std::min( std::size_t( tail - head ), depth( channel ) ) );
+    }
+
+    /**
+     * producer_room - free units as the producer sees them, goes to
+     * the consumer's line for a new head only if the cached one
+     * leaves less than wanted.
+     */
+    inline static std::size_t producer_room( PARENTNODE *channel,
+                                             const std::uint64_t tail,
+                                             const std::size_t wanted )
+    {
+        const auto d    = depth( channel );
+        auto &cached    = channel->ctrl_spsc.cached_head;
+        auto room       = d - std::size_t( tail - cached );
+        if( room < wanted )
+        {
+            cached = load_head( channel, std::memory_order_acquire );
+            room   = d - std::size_t( tail - cached );
+        }
+        return( room );
+    }
+
+    /**
+     * consumer_avail - units as the consumer sees them, same deal
+     * with the producer's line and the tail.
+     */
+    inline static std::size_t consumer_avail( PARENTNODE *channel,
+                                              const std::uint64_t head,
+                                              const std::size_t wanted )
+    {
+        auto &cached    = channel->ctrl_spsc.cached_tail;
+        auto avail      = std::size_t( cached - head );
+        if( avail < wanted )
+        {
+            cached = load_tail( channel, std::memory_order_acquire );
+            avail  = std::size_t( cached - head );
+        }
+        return( avail );
+    }
+
+    /**
+     * init - different initialization condition than the mpmc
+     * queue, both are counts here, not offsets.
+     */
+    static void init( PARENTNODE *channel )
+    {
+        channel->ctrl_all.data_head =
+            channel->ctrl_all.data_tail = 0;
+        channel->ctrl_spsc.cached_head =
+            channel->ctrl_spsc.cached_tail = 0;
+    }
+}; /** end class spsc_index **/
+
+} /** end namespace ipc **/
+
+#endif /* END SPSC_INDEX_HPP */
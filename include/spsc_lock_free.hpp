@@ -21,108 +21,57 @@
 #define SPSC_LOCK_FREE_HPP  1
 #include "bufferdefs.hpp"
 #include "ch_entries_spsc.hpp"
+#include "spsc_index.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
 
 namespace ipc
 {
 
+/**
+ * spsc_lock_free_queue - single producer, single consumer ring of 
+ * buffer offsets, see spsc_index for how head and tail work.
+ */
 template < class PARENTNODE, class LOCKFREE_NODE, class TRANSLATE > 
-    class spsc_lock_free_queue
+    class spsc_lock_free_queue : public spsc_index< PARENTNODE >
 {
 private:
     
     spsc_lock_free_queue() = delete;
     
     using self_t = spsc_lock_free_queue< PARENTNODE, LOCKFREE_NODE, TRANSLATE >;
-    
-    /**
-     * inc
-     */
-    inline 
-    static 
-    void
-    inc_tail( PARENTNODE *channel ) 
-    {
-       auto &ptr = channel->ctrl_all.data_tail;
-       ptr = ( ptr + 1 ) % ipc::ch_entries_spsc::n_entries;
-       if( ptr == 0 )
-       {
-          channel->ctrl_spsc.wrap_tail++;
-       }
-    }
-    
+
     /**
-     * inc
+     * entries - the ring, spsc_q unless the channel is deeper than
+     * that, then it's wherever ring_base says.
      */
-    inline 
-    static 
-    void
-    inc_head( PARENTNODE *channel ) 
+    inline static ipc::ptr_offset_t* entries( PARENTNODE *channel, void *buffer_base )
     {
-       auto &ptr = channel->ctrl_all.data_head;
-       ptr = ( ptr + 1 ) % ipc::ch_entries_spsc::n_entries;
-       if( ptr == 0 )
-       {
-          channel->ctrl_spsc.wrap_head++;
-       }
-    }
-
-public:
-    inline static std::size_t size( PARENTNODE *channel )
-    {
-        for( ;; )
+        const auto ring_base = channel->meta.ring_base;
+        if( ring_base == ipc::invalid_ptr_offset )
         {
-TOP:        
-            const auto   wrap_write = 
-                channel->ctrl_spsc.wrap_tail.load( std::memory_order_relaxed );
-            const auto   wrap_read  = 
-                channel->ctrl_spsc.wrap_head.load( std::memory_order_relaxed );
-            const auto   wpt = 
-                channel->ctrl_all.data_tail.load( std::memory_order_relaxed );
-            const auto   rpt = 
-                channel->ctrl_all.data_head.load( std::memory_order_relaxed );
-
-                   
-            if( wpt == rpt)
-            {
-               /** expect most of the time to be full **/
-               if(  wrap_read < wrap_write )
-               {
-                  return( ipc::ch_entries_spsc::n_entries );
-               }
-               else if( wrap_read > wrap_write )
-               {
-                  goto TOP;
-               }
-               else
-               {
-                  return( 0 );
-               }
-            }
-            else if( rpt < wpt )
-            {
-               return( wpt - rpt );
-            }
-            else if( rpt > wpt )
-            {
-               return( ipc::ch_entries_spsc::n_entries - rpt + wpt ); 
-            }
-            return( 0 );
-        } /** end for **/
-        return( 0 ); /** keep some compilers happy **/
+            return( channel->spsc_q.entry );
+        }
+        return( (ipc::ptr_offset_t*) TRANSLATE::translate_block( buffer_base, ring_base ) );
     }
 
+public:
     
     /**
      * min_size - returns the minimum size that this queue could be
      * from the consumer's perspective. Basically instead of going
-     * through and checking head/tail pointers, just check the credits.
+     * through and checking head/tail pointers, just check the cached
+     * tail.
      */
     inline static std::size_t min_consumer_size( PARENTNODE *channel )
     {
-        const auto credits = channel->meta.cons_credits.load( std::memory_order_relaxed );
-        if( credits != 0 )
+        const auto head = self_t::load_head( channel, std::memory_order_relaxed );
+        const auto n    = std::size_t( channel->ctrl_spsc.cached_tail - head );
+        if( n != 0 )
         {
-            return( credits );
+            return( n );
         }
         //ELSE
         return( self_t::size( channel ) );
@@ -136,34 +85,10 @@ TOP:
     */
    inline static std::size_t space_avail( PARENTNODE *channel )
    {
-      return( ipc::ch_entries_spsc::n_entries - self_t::size( channel ) );
+      return( self_t::depth( channel ) - self_t::size( channel ) );
    }
 
     
-
-   
-
-    
-    /**
-     * init -  
-     * @return - void.
-     */
-    static void init( PARENTNODE *channel )
-    {
-        /**
-         * different initialization condition than the mpmc
-         * queue.
-         */
-        channel->ctrl_all.data_head = 
-            channel->ctrl_all.data_tail = 0;
-        /**
-         * initialize the credit count for producer to total available
-         */
-        channel->meta.prod_credits = ipc::ch_entries_spsc::n_entries;
-        //consumer credits already zero. 
-        return;
-    }
-
     /**
      * push - push a node into the LF queue.
      * @param meta - the lock-free channel header info.
@@ -179,45 +104,75 @@ TOP:
                               LOCKFREE_NODE *node_to_add, 
                               void *buffer_base )
     {
-        //check credits on tail
-PUSH_RETRY:
-        if( channel->meta.prod_credits > 0 )
-        {   
-            const auto offset_to_add = 
-                TRANSLATE::calculate_block_offset( buffer_base,
-                                                   node_to_add );
-            channel->spsc_q.entry[ 
-                channel->ctrl_all.data_tail
-            ] = offset_to_add;
-#if __aarch64__
-            /** 
-             * probably can get away with inner shareable 
-             * barrier only here, but just in case....
-             */
-            __asm__ volatile( "dsb st" : : : );
-#endif
-            inc_tail( channel );
-            channel->meta.prod_credits--;
-            node_to_add = nullptr;
-            return( ipc::tx_success );
-        }
-        //else if credits == 0
-        else
+        const auto tail = self_t::load_tail( channel, std::memory_order_relaxed );
+        if( self_t::producer_room( channel, tail, 1 ) == 0 )
         {
-            const auto curr_space = self_t::space_avail( channel );
-            if( curr_space == 0 )
-            {
-                return( ipc::tx_retry );
-            }
-            else
-            {
-                channel->meta.prod_credits = curr_space;
-                goto PUSH_RETRY;
-            }
+            return( ipc::tx_retry );
         }
+        self_t::entries( channel, buffer_base )[ tail & channel->meta.ring_mask ] = 
+            TRANSLATE::calculate_buffer_offset( buffer_base, node_to_add );
+        /** release, entry is visible before the consumer sees the tail move **/
+        channel->ctrl_all.data_tail.store( tail + 1, std::memory_order_release );
         return( ipc::tx_success );
     }
 
+    /**
+     * push_n - push as many of nodes[ 0, count ) as there's room for
+     * with a single update of the tail, the consumer sees either none
+     * of them or all of them.
+     * @return - number pushed, zero if the queue is full.
+     */
+    static std::size_t push_n( PARENTNODE *channel, 
+                               LOCKFREE_NODE **nodes, 
+                               const std::size_t count,
+                               void *buffer_base )
+    {
+        const auto tail = self_t::load_tail( channel, std::memory_order_relaxed );
+        const std::size_t n = 
+            std::min( count, self_t::producer_room( channel, tail, count ) );
+        if( n == 0 )
+        {
+            return( 0 );
+        }
+        const auto mask = channel->meta.ring_mask;
+        auto *entry     = self_t::entries( channel, buffer_base );
+        for( std::size_t i( 0 ); i < n; i++ )
+        {
+            entry[ ( tail + i ) & mask ] = 
+                TRANSLATE::calculate_buffer_offset( buffer_base, nodes[ i ] );
+        }
+        channel->ctrl_all.data_tail.store( tail + n, std::memory_order_release );
+        return( n );
+    }
+
+    /**
+     * pop_n - pop up to count nodes into receive_nodes with a single
+     * update of the head.
+     * @return - number popped, zero if there was nothing.
+     */
+    static std::size_t pop_n( PARENTNODE *channel, 
+                              LOCKFREE_NODE **receive_nodes, 
+                              const std::size_t count,
+                              void *buffer_base )
+    {
+        const auto head = self_t::load_head( channel, std::memory_order_relaxed );
+        const std::size_t n = 
+            std::min( count, self_t::consumer_avail( channel, head, count ) );
+        if( n == 0 )
+        {
+            return( 0 );
+        }
+        const auto mask = channel->meta.ring_mask;
+        auto *entry     = self_t::entries( channel, buffer_base );
+        for( std::size_t i( 0 ); i < n; i++ )
+        {
+            receive_nodes[ i ] = (LOCKFREE_NODE*) TRANSLATE::translate( buffer_base, 
+                entry[ ( head + i ) & mask ] );
+        }
+        channel->ctrl_all.data_head.store( head + n, std::memory_order_release );
+        return( n );
+    }
+
     /**
      * pop - pop a node from the ring buffer
      */
@@ -225,29 +180,20 @@ PUSH_RETRY:
                              LOCKFREE_NODE **receive_node, 
                              void *buffer_base )
     {
-        if( channel->meta.cons_credits == 0 )
+        const auto head = self_t::load_head( channel, std::memory_order_relaxed );
+        if( self_t::consumer_avail( channel, head, 1 ) == 0 )
         {
-            channel->meta.cons_credits = self_t::size( channel );
             return( ipc::tx_retry );
         }
-        //else 
-        const auto offset = channel->spsc_q.entry[ channel->ctrl_all.data_head ];
-
+        const auto offset = 
+            self_t::entries( channel, buffer_base )[ head & channel->meta.ring_mask ];
         *receive_node =
-            (LOCKFREE_NODE*) TRANSLATE::translate_block( buffer_base, offset );
-#if __aarch64__
-            /** 
-             * Capture pointer at this slot before incrementing
-             * given another agent can over-write it...not likely,
-             * but could happen.
-             */
-            __asm__ volatile( "dsb ld" : : : );
-#endif
-        
-        self_t::inc_head( channel );
-
-        //decrement credits
-        channel->meta.cons_credits--;
+            (LOCKFREE_NODE*) TRANSLATE::translate( buffer_base, offset );
+        /** 
+         * release, the slot is read before the producer sees it
+         * free and writes over it.
+         */
+        channel->ctrl_all.data_head.store( head + 1, std::memory_order_release );
         return( ipc::tx_success );
     }
 
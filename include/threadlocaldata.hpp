@@ -24,6 +24,12 @@
 #include <map>
 #include "bufferdefs.hpp"
 #include "channelinfo.hpp"
+#include "slab.hpp"
+#include "magazine.hpp"
+#include "deferred_free.hpp"
+#include "refill_policy.hpp"
+#include "alloc_stats.hpp"
+#include "spsc_arena.hpp"
 #include "sem.hpp"
 
 namespace ipc
@@ -34,6 +40,22 @@ struct channel_info;
 struct allocate_metadata;
 
 
+/**
+ * parked_run - a channel's local allocation, spare and slabs for one
+ * numa node, set aside while records for another node are carved so 
+ * going back to it doesn't cost a new run (and an mbind).
+ */
+struct parked_run
+{
+    bool                valid             = false;
+    std::int32_t        node              = ipc::any_numa_node;
+    ipc::ptr_offset_t   local_allocation  = ipc::invalid_ptr_offset;
+    std::size_t         blocks_available  = 0;
+    ipc::ptr_offset_t   spare_allocation  = ipc::invalid_ptr_offset;
+    std::size_t         spare_blocks      = 0;
+    ipc::slab_cursor    slab[ ipc::slab::n_classes ];
+};
+
 struct local_allocation_info
 {
     local_allocation_info() = default;
@@ -43,7 +65,25 @@ struct local_allocation_info
     local_allocation_info( const local_allocation_info &other ) : 
         local_allocation( other.local_allocation ),
         blocks_available( other.blocks_available ),
-        dir( other.dir ){}
+        spare_allocation( other.spare_allocation ),
+        spare_blocks( other.spare_blocks ),
+        refill( other.refill ),
+        dir( other.dir ),
+        arena( other.arena ),
+        arena_base( other.arena_base ),
+        recycle( other.recycle ),
+        channel( other.channel ),
+        run_node( other.run_node )
+    {
+        for( std::size_t i( 0 ); i < ipc::slab::n_classes; i++ )
+        {
+            slab[ i ] = other.slab[ i ];
+        }
+        for( std::size_t i( 0 ); i < max_parked_runs; i++ )
+        {
+            parked[ i ] = other.parked[ i ];
+        }
+    }
     
 
     /** 
@@ -61,7 +101,42 @@ struct local_allocation_info
      * This value is zero, more space must be allocated. 
      */
     std::size_t         blocks_available  = 0;
+
+    /**
+     * what was left of the previous local allocation when it was
+     * refilled, kept instead of going back to the heap, the two
+     * are swapped when a refill fits in it.
+     */
+    ipc::ptr_offset_t    spare_allocation   = ipc::invalid_ptr_offset;
+    std::size_t         spare_blocks      = 0;
+
+    /** how much to ask for next time, see refill_policy.hpp **/
+    ipc::refill_policy  refill;
     ipc::direction_t    dir               = ipc::dir_not_set;
+
+    /**
+     * current slab for each small record size class, these
+     * blocks are carved out of the local allocation above. 
+     */
+    ipc::slab_cursor    slab[ ipc::slab::n_classes ];
+
+    /**
+     * spsc record channels with an arena, set for the producer,
+     * records come out of here before anything else is tried.
+     */
+    ipc::ch_arena_spsc  *arena            = nullptr;
+    ipc::byte_t         *arena_base       = nullptr;
+
+    /** recycle lane of an spsc record channel, set for the producer **/
+    ipc::ch_recycle_spsc *recycle         = nullptr;
+
+    ipc::channel_info   *channel          = nullptr;
+    /** numa node the local allocation above is bound to **/
+    std::int32_t        run_node          = ipc::any_numa_node;
+
+    /** runs for other nodes, see ipc::buffer::switch_run_node **/
+    static constexpr std::size_t max_parked_runs = 3;
+    ipc::parked_run     parked[ max_parked_runs ];
 };
 
 struct thread_local_data
@@ -109,6 +184,20 @@ struct thread_local_data
     std::map< ipc::channel_id_t, 
               ipc::local_allocation_info > channel_local_allocation;
 
+    /**
+     * runs freed by this thread that haven't been handed
+     * back to the global heap yet, see magazine.hpp.
+     */
+    ipc::block_magazine magazine;
+
+    /**
+     * runs too big for the magazine waiting to be handed
+     * back in a batch, see deferred_free.hpp.
+     */
+    ipc::deferred_free  deferred;
+
+    /** counts not yet added to the buffer's, see alloc_stats.hpp **/
+    ipc::local_alloc_stats  stats;
 };
 
 
@@ -19,6 +19,7 @@
  */
 #ifndef TRANSLATE_HPP
 #define TRANSLATE_HPP  1
+#include <cstddef>
 #include "bufferdefs.hpp"
 namespace ipc
 {
@@ -57,6 +58,38 @@ struct translate_helper
     static ipc::ptr_offset_t calculate_block_offset( const void * const buffer_base,
                                                      const void * const address );
 
+    /**
+     * extent_resolver_t - maps extent (> 0) of the buffer passed in as 
+     * ctx into this address space, returns the data base of the extent
+     * or nullptr if it doesn't exist (yet).
+     */
+    using extent_resolver_t = void* (*)( void *ctx, const std::uint8_t extent );
+
+    /**
+     * register_buffer - add the buffer whose data starts at base to 
+     * the process local extent table, after this offsets with an 
+     * extent index are translated for it. Extents are mapped with 
+     * resolver the first time something needs them.
+     * @param base - data base of the buffer (extent zero)
+     * @param size - bytes in the data buffer, same for every extent
+     * @return false if the table is full.
+     */
+    static bool register_buffer( void                    *base,
+                                 const std::size_t       size,
+                                 extent_resolver_t       resolver,
+                                 void                    *ctx );
+
+    static void unregister_buffer( void *base );
+
+    /**
+     * get_extent - data base of the given extent of the buffer, 
+     * if map is false this only returns what's already mapped.
+     * @return nullptr if the extent isn't there.
+     */
+    static void* get_extent( void               *base, 
+                             const std::uint8_t extent,
+                             const bool         map = true );
+
 };
 
 } //end namespace ipc
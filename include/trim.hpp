@@ -0,0 +1,71 @@
+/**
+ * trim.hpp - state for handing idle free memory back to the OS, see
+ * ipc::buffer::trim. The data buffer and each extent are split into
+ * granules of 2^granule_pow_two bytes, a granule the heap has had
+ * entirely free from one scan to the next (at least trim_state::idle_ns
+ * apart) is punched out of the shared memory segment (madvise 
+ * MADV_REMOVE, MADV_FREE doesn't apply to shared mappings) so it stops
+ * counting against every process that has it mapped. The pages come
+ * back zeroed the next time anybody writes to them.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 18:24:51 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TRIM_HPP
+#define TRIM_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "bufferdefs.hpp"
+
+namespace ipc
+{
+
+/**
+ * trim_map - per heap (buffer or extent) granule bits, only touched
+ * with the heap locked by whoever holds trim_state::busy.
+ */
+struct trim_map
+{
+    /** same as the largest allocation block, so a granule is never part of one **/
+    static constexpr std::uint8_t   granule_pow_two = ipc::max_block_size_pow_two;
+    static constexpr std::size_t    granule_bytes   = ( std::size_t( 1 ) << granule_pow_two );
+    static constexpr std::size_t    max_granules    =
+        ( std::size_t( 1 ) << ( ipc::max_buffer_size_pow_two - granule_pow_two ) );
+    static constexpr std::size_t    words           = ( max_granules + 63 ) >> 6;
+
+    /** granule was entirely free at the last scan **/
+    std::uint64_t   seen_free[ words ]  = {};
+    /** granule has been punched out and not handed out since **/
+    std::uint64_t   trimmed[ words ]    = {};
+};
+
+struct trim_state
+{
+    /** zero turns the opportunistic trim off, see buffer_config **/
+    std::atomic< std::int64_t >     idle_ns         = { 0 };
+    /** steady clock, ns, of the last scan by any process **/
+    std::atomic< std::int64_t >     last_scan_ns    = { 0 };
+    /** one trimmer at a time across every process **/
+    std::atomic< bool >             busy            = { false };
+    /** for the buffer itself, extents carry their own **/
+    ipc::trim_map                   map;
+};
+
+} /** end namespace ipc **/
+
+#endif /* END TRIM_HPP */
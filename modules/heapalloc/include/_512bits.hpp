@@ -24,14 +24,78 @@ namespace alloc
 
 struct _512bits
 {
+    /**
+     * kernel - implementations of the bit scans below, the best one
+     * the CPU supports is picked at runtime (CPUID) the first time
+     * either scan is called. 
+     * generic  - original bit at a time version, any ISA
+     * scalar   - popcnt + tzcnt, walks runs rather than bits
+     * avx2     - run search by doubling over the full 512b vector
+     * avx512   - same as avx2 with one register and vpopcntq
+     */
+    enum kernel : std::uint8_t
+    {
+        generic = 0,
+        scalar,
+        avx2,
+        avx512,
+        n_kernels
+    };
+
+    static bool     kernel_supported( kernel k );
+    static kernel   active_kernel();
+
+    /**
+     * total_bits_set - count of set (allocated) bits.
+     */
     static std::uint16_t total_bits_set( _512bits *f );
+    static std::uint16_t total_bits_set( _512bits *f, kernel k );
 
+    /**
+     * find_longest_contiguous_zeros - returns { length, start } of
+     * the longest stretch of unset bits, if there's a tie the stretch
+     * at the highest offset wins. All set returns { 0, 0 }.
+     */
     static std::pair< std::int32_t, std::int32_t > find_longest_contiguous_zeros( _512bits *f );
+    static std::pair< std::int32_t, std::int32_t > find_longest_contiguous_zeros( _512bits *f,
+                                                                                 kernel k );
+    
+    static std::uint16_t total_bits_set_generic( _512bits *f );
+    static std::pair< std::int32_t, std::int32_t > find_longest_contiguous_zeros_generic( _512bits *f );
 
     static void set_bit( std::uint16_t x, _512bits *f );
     
     static void unset_bit( std::uint16_t x, _512bits *f );
 
+    /**
+     * set_range/unset_range - set or clear bits [start, end) a 
+     * word at a time, is_range_unset - true if all of [start, end)
+     * are clear.
+     */
+    static void set_range( std::uint16_t start, std::uint16_t end, _512bits *f );
+    static void unset_range( std::uint16_t start, std::uint16_t end, _512bits *f );
+    static bool is_range_unset( std::uint16_t start, std::uint16_t end, _512bits *f );
+
+    /**
+     * range_mask - bits [lo, hi) of a single word, 0 <= lo < hi <= 64.
+     */
+    static constexpr std::uint64_t range_mask( const std::uint16_t lo,
+                                               const std::uint16_t hi )
+    {
+        return( ( hi == 64 ? ~0ULL : ( ( 1ULL << hi ) - 1 ) ) &
+                    ~( ( 1ULL << lo ) - 1 ) );
+    }
+
+    /**
+     * get_word - return a pointer to the 64b word holding
+     * bits [ index * 64, (index * 64) + 63 ], used by callers
+     * that need to operate on whole words (e.g., atomically).
+     */
+    static std::uint64_t* get_word( std::uint8_t index, _512bits *f );
+
+    constexpr static std::uint8_t  n_words      = 8;
+    constexpr static std::uint16_t word_bits    = 64;
+
 
     std::uint64_t   _000_063;
     std::uint64_t   _064_127;
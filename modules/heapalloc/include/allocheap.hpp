@@ -29,7 +29,11 @@
 namespace alloc
 {
 
-using node_index_t = std::uint16_t;
+/** 
+ * leaves go to 2^16 at the largest buffer (2^37 / 4KiB blocks / 512),
+ * and children of the last slots go past that, so 32 bits.
+ */
+using node_index_t = std::uint32_t;
 
 struct data_node
 {
@@ -51,8 +55,35 @@ inline std::ostream& operator << ( std::ostream &stream, const data_node &n )
 }
 
 
+/**
+ * heap_mode - selects the synchronization model of the heap. 
+ * locked    - caller must serialize every call (e.g., with a semaphore),
+ *             this is the original priority heap.
+ * lock_free - leaves are claimed with CAS, see lockfreeheap.hpp, any
+ *             number of threads/processes may call concurrently.
+ * buddy     - buddy system, see buddyheap.hpp, locked like the original
+ *             but holds up better when request sizes are mixed.
+ */
+enum heap_mode : std::uint8_t
+{
+    locked      = 0,
+    lock_free   = 1,
+    buddy       = 2
+};
+
+/**
+ * uninitialized - construct a heap without setting it up, for when
+ * the owner is going to call initialize with the real size anyway 
+ * (e.g., a heap sized for the largest buffer placed in a smaller 
+ * one), so the default constructor's full sized initialize would
+ * only be thrown away. Nothing may use the heap until initialize.
+ */
+struct uninitialized_t {};
+static constexpr uninitialized_t uninitialized = {};
+
 template < int TotalMemSizePowerTwo /** must be an integer for power of two **/, 
-           int BlockSizePowerTwo > 
+           int BlockSizePowerTwo,
+           heap_mode Mode = alloc::locked > 
 #ifdef TESTHEAP
            struct 
 #else
@@ -65,8 +96,11 @@ public:
 #endif
 
     /** make typing faster, use this type for self **/
-    using self_type = heap< TotalMemSizePowerTwo, BlockSizePowerTwo >;
+    using self_type = heap< TotalMemSizePowerTwo, BlockSizePowerTwo, Mode >;
     using range_t   = std::pair< std::int32_t, std::int32_t >;
+
+    /** callers must hold a lock around every call **/
+    constexpr static bool is_lock_free = false;
     
     /** 
      * this block size is the internal leaf representation, currently
@@ -83,16 +117,13 @@ public:
    
     heap()
     {
-        std::memset( offsetArray, 0x0, sizeof( _512bits ) * self_type::numElements );
-        //iterate over tree.
-        for( std::uint64_t i( 0 ); i < self_type::numElements ; i++ )
-        {
-            self_type::add( i,this );
-        }
-
-        overall_blocks = self_type::blocksize_bits * self_type::numElements;
+        self_type::initialize( this );
     }
 
+    explicit heap( const alloc::uninitialized_t )
+    {
+        /** caller must initialize **/
+    }
     
     /**
      * initialize - call this if you really need to trash the heap and 
@@ -105,14 +136,64 @@ public:
      */
     static void initialize( self_type *h)
     {
-        std::memset( &h->offsetArray, 0x0, sizeof( _512bits ) * self_type::numElements );
-        //iterate over tree.
-        h->n = 0;
-        for( std::uint64_t i( 0 ); i < self_type::numElements ; i++ )
+        self_type::initialize( h, self_type::blocksize_bits * self_type::numElements );
+    }
+    
+    /**
+     * initialize - same as above, but only the first active_blocks
+     * are handed out, the template parameters then just set the 
+     * largest size this heap can ever manage. Leaves past the active
+     * ones never make it into the heap, a partial last leaf has its
+     * tail marked as used.
+     * @param h - self_type - memory to use for heap
+     * @param active_blocks - blocks actually backed by memory, must 
+     * be at least one and no more than the template maximum.
+     */
+    static void initialize( self_type *h, const std::uint64_t active_blocks )
+    {
+        assert( active_blocks > 0 && 
+                active_blocks <= self_type::blocksize_bits * self_type::numElements );
+        h->active_leaves = ( active_blocks + self_type::blocksize_bits - 1 ) / 
+                                self_type::blocksize_bits;
+        /**
+         * an empty heap is the same every time, every leaf is free so
+         * add()-ing them in order never swaps anything and slot i ends
+         * up holding leaf i. Write that out directly instead of paying
+         * a bitmap scan and a bubble up per leaf. A partial last leaf
+         * is the smallest, so it's already where add() would put it.
+         * Leaves past the active ones are never looked at, leave them.
+         */
+        std::memset( &h->offsetArray, 0x0, sizeof( _512bits ) * h->active_leaves );
+        for( std::uint64_t i( 0 ); i < h->active_leaves; i++ )
         {
-            self_type::add( i, h );
+            h->arr[ i ] = { self_type::blocksize_bits, 
+                            self_type::blocksize_bits, 
+                            static_cast< node_index_t >( i ), 
+                            0 };
+            h->pos[ i ] = static_cast< node_index_t >( i );
         }
-        h->overall_blocks = self_type::blocksize_bits * self_type::numElements;
+        const std::uint16_t tail = active_blocks % self_type::blocksize_bits;
+        if( tail != 0 )
+        {
+            const auto last = h->active_leaves - 1;
+            _512bits::set_range( tail, 
+                                 self_type::blocksize_bits, 
+                                 &h->offsetArray[ last ] );
+            h->arr[ last ].blocks_free      = tail;
+            h->arr[ last ].contiguous_free  = tail;
+        }
+        h->n = static_cast< std::int32_t >( h->active_leaves );
+        h->overall_blocks = active_blocks;
+        h->total_blocks   = active_blocks;
+    }
+
+    /**
+     * get_total_blocks - blocks this heap was initialized to manage,
+     * free or not.
+     */
+    static std::size_t get_total_blocks( self_type *h )
+    {
+        return( h->total_blocks );
     }
 
     /** 
@@ -123,10 +204,15 @@ public:
 
     /**
      * get_n_blocks - return offset with start + n_blocks of contiguous storage
-     * that you can allocate. 
+     * that you can allocate. Requests larger than a single leaf 
+     * (blocksize_bits) are handed to get_span.
      */
     static std::int32_t get_n_blocks( const std::uint32_t n_blocks, self_type *h )
     {
+        if( n_blocks > self_type::blocksize_bits )
+        {
+            return( self_type::get_span( n_blocks, h ) );
+        }
         auto &top_of_heap( self_type::get_top( h ) );
         if( top_of_heap.contiguous_free >= n_blocks )
         {
@@ -136,11 +222,9 @@ public:
                     top_of_heap.offset_to_contiguous_free; 
             
             //reset block values
-            for( auto i( top_of_heap.offset_to_contiguous_free ); 
-                    i < (top_of_heap.offset_to_contiguous_free + n_blocks); i++ )
-            {
-                _512bits::set_bit( i, &h->offsetArray[ bl ] );
-            }
+            _512bits::set_range( top_of_heap.offset_to_contiguous_free, 
+                                 top_of_heap.offset_to_contiguous_free + n_blocks,
+                                 &h->offsetArray[ bl ] );
             self_type::updateEntry( top_of_heap, &h->offsetArray[ bl ] );
             self_type::trickleDown( 0, h );
             h->overall_blocks -=  n_blocks;
@@ -203,31 +287,32 @@ public:
                                  const std::int64_t n_blocks, 
                                  self_type *h )
     {
-        //get index (integer div)
-        const auto index = start_block / self_type::blocksize_bits;
-        //get offset (mod)
-        const auto offset_start = start_block % self_type::blocksize_bits;
-        //unset bits
-        for( auto i( offset_start ); i < (offset_start+n_blocks); i++ )
-        {
-            alloc::_512bits::unset_bit( i, &h->offsetArray[ index ] );
-        }
-        //search backwards through the list
-        for( std::int64_t j( self_type::numElements - 1 ); j >= 0; j-- )
+        /** 
+         * a span from get_span covers more than one leaf, walk
+         * it leaf by leaf, most of the time this is one pass.
+         */
+        std::int64_t block      = start_block;
+        std::int64_t remaining  = n_blocks;
+        while( remaining > 0 )
         {
-            if( h->arr[ j ].index == index )
-            {
-                self_type::updateEntry( h->arr[ j ], &h->offsetArray[ index ] );
-                self_type::bubbleUp( j, h );
-                break;
-            }
-            else
-            {
-                continue;
-            }
+            //get index (integer div)
+            const auto index = block / self_type::blocksize_bits;
+            //get offset (mod)
+            const auto offset_start = block % self_type::blocksize_bits;
+            const auto len = std::min< std::int64_t >( remaining, 
+                                                       self_type::blocksize_bits - offset_start );
+            //unset bits
+            alloc::_512bits::unset_range( offset_start, 
+                                          offset_start + len, 
+                                          &h->offsetArray[ index ] );
+            //find the heap slot for this leaf, free space only grows so just bubble up
+            const auto j = h->pos[ index ];
+            assert( h->arr[ j ].index == index );
+            self_type::updateEntry( h->arr[ j ], &h->offsetArray[ index ] );
+            self_type::bubbleUp( j, h );
+            block       += len;
+            remaining   -= len;
         }
-        //trickle down head
-        self_type::trickleDown( 0, h );
         h->overall_blocks +=  n_blocks;
     }
     
@@ -245,9 +330,79 @@ public:
         return( h->overall_blocks );
     }
 
+    /**
+     * for_each_free_run - call f( start_block, length ) for every 
+     * maximal run of free blocks, in block order, runs carry across
+     * leaves. Caller holds the lock, it's a walk of every active leaf.
+     */
+    template < class F > static void for_each_free_run( self_type *h, F &&f )
+    {
+        helper::free_run_walker< F > walker( f );
+        for( std::uint64_t leaf( 0 ); leaf < h->active_leaves; leaf++ )
+        {
+            for( std::uint8_t w( 0 ); w < _512bits::n_words; w++ )
+            {
+                walker.add_word( *_512bits::get_word( w, &h->offsetArray[ leaf ] ),
+                                 ( leaf * self_type::blocksize_bits ) + 
+                                    ( w * _512bits::word_bits ) );
+            }
+        }
+        walker.end();
+    }
+
 #ifndef TESTHEAP
 private:
 #endif
+    /**
+     * get_span - allocate more than one leaf worth of blocks. The 
+     * span always starts at the beginning of a leaf, every leaf but 
+     * the last must be completely free and the last needs enough 
+     * free blocks at its front for whatever is left over. This is
+     * a linear walk over the leaves, but it's only for large 
+     * allocations where that cost is noise.
+     * @return first block of the span or -1 if none found.
+     */
+    static std::int32_t get_span( const std::uint32_t n_blocks, self_type *h )
+    {
+        const std::uint64_t full_leaves = n_blocks / self_type::blocksize_bits;
+        const std::uint16_t tail        = n_blocks % self_type::blocksize_bits;
+        const std::uint64_t n_leaves    = full_leaves + ( tail != 0 ? 1 : 0 );
+        if( n_leaves > h->active_leaves )
+        {
+            return( -1 );
+        }
+        std::uint64_t run = 0;
+        for( std::uint64_t leaf( 0 ); leaf < h->active_leaves; leaf++ )
+        {
+            const bool fits = ( run < full_leaves ? 
+                h->arr[ h->pos[ leaf ] ].blocks_free == self_type::blocksize_bits :
+                _512bits::is_range_unset( 0, tail, &h->offsetArray[ leaf ] ) );
+            if( ! fits )
+            {
+                run = 0;
+                continue;
+            }
+            if( ++run < n_leaves )
+            {
+                continue;
+            }
+            //found it, claim every leaf in the span
+            const auto first = leaf + 1 - n_leaves;
+            for( auto l( first ); l <= leaf; l++ )
+            {
+                const std::uint16_t len = ( l == leaf && tail != 0 ? 
+                                            tail : self_type::blocksize_bits );
+                _512bits::set_range( 0, len, &h->offsetArray[ l ] );
+                const auto j = h->pos[ l ];
+                self_type::updateEntry( h->arr[ j ], &h->offsetArray[ l ] );
+                self_type::trickleDown( j, h );
+            }
+            h->overall_blocks -= n_blocks;
+            return( first * self_type::blocksize_bits );
+        }
+        return( -1 );
+    }
+
     static constexpr node_index_t  parent( const node_index_t current_index )
     {
         return( ( current_index - 1 ) >> 1 );
@@ -302,6 +457,8 @@ private:
         const auto temp_a = h->arr[ a ];
         h->arr[ a ] = h->arr[ b ];
         h->arr[ b ] = temp_a;
+        h->pos[ h->arr[ a ].index ] = a;
+        h->pos[ h->arr[ b ].index ] = b;
         return;
     }
 
@@ -348,6 +505,7 @@ private:
         auto *entry     = &h->offsetArray[ entry_index ];
         auto &node_data = h->arr[ h->n ];
         node_data.index = entry_index;
+        h->pos[ entry_index ] = h->n;
         //get number of zeros totalbits - ones
         self_type::updateEntry( node_data, entry );
         h->n++;
@@ -365,7 +523,7 @@ private:
         do{
             auto j = -1;
             auto r = self_type::go_right( i );
-            if( r < h->n && self_type::compare(  r, i, h ) > 0 )
+            if( r < static_cast< node_index_t >( h->n ) && self_type::compare(  r, i, h ) > 0 )
             {
                 auto l = self_type::go_left( i );
                 if( self_type::compare( l, r, h ) > 0 ) 
@@ -380,7 +538,7 @@ private:
             else 
             {
                 auto l = self_type::go_left( i );
-                if( l < h->n && self_type::compare(  l, i, h ) > 0 ) 
+                if( l < static_cast< node_index_t >( h->n ) && self_type::compare(  l, i, h ) > 0 ) 
                 {
                     j = l;
                 }
@@ -397,12 +555,19 @@ private:
 //data
     data_node       arr[ 1 << treeDepth ];
     _512bits        offsetArray[ numElements ]; 
+    /** reverse map, leaf index -> slot in arr, kept up to date by swap **/
+    node_index_t    pos[ numElements ];
     std::int32_t    n               = 0;
     std::size_t     overall_blocks  = 0;
+    /** leaves backed by memory, see initialize **/
+    std::uint64_t   active_leaves   = numElements;
+    std::size_t     total_blocks    = 0;
 };
 
 
 } /** end namespace alloc **/
 
+#include "lockfreeheap.hpp"
+#include "buddyheap.hpp"
 
 #endif /* END ALLOCTREE_HPP */
@@ -0,0 +1,406 @@
+/**
+ * buddyheap.hpp - buddy system version of the block heap, selected
+ * with alloc::heap< total, block, alloc::buddy >. Same interface and
+ * locking rules as the locked heap (callers serialize), different
+ * trade: a request for n blocks comes from an aligned free block of
+ * the next power of two up, the tail past n stays free, and frees
+ * merge with their buddy as far up as they can, so mixed sizes don't
+ * chop the buffer into leaf sized pieces. Allocate and free are both
+ * O(log n).
+ *
+ * The bookkeeping is a complete binary tree, one byte per node holding
+ * the largest free aligned block in the subtree (order + 1, zero for
+ * nothing free), down to 64 block words whose state is a plain bitmap.
+ * A node that is entirely free or entirely used is authoritative for
+ * everything under it, what's below is only brought up to date when
+ * something needs to look there, which is what lets any range (not
+ * just what was handed out) be freed, and lets initialize touch only
+ * O(log n) nodes. That's ~1.25 bits per block, about the same as the
+ * leaf heap.
+ *
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 12:16:30 2026
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BUDDYHEAP_HPP
+#define BUDDYHEAP_HPP  1
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <utility>
+#include <algorithm>
+#include "helper.hpp"
+
+namespace alloc
+{
+
+template < int TotalMemSizePowerTwo,
+           int BlockSizePowerTwo >
+#ifdef TESTHEAP
+           struct
+#else
+           class
+#endif
+           heap< TotalMemSizePowerTwo, BlockSizePowerTwo, alloc::buddy >
+{
+#ifndef TESTHEAP
+public:
+#endif
+
+    using self_type = heap< TotalMemSizePowerTwo, BlockSizePowerTwo, alloc::buddy >;
+    using range_t   = std::pair< std::int32_t, std::int32_t >;
+
+    /** callers must hold a lock around every call **/
+    constexpr static bool is_lock_free = false;
+
+    /** order of the root, i.e., log2 of the blocks managed **/
+    constexpr static std::uint8_t  max_order  = TotalMemSizePowerTwo - BlockSizePowerTwo;
+    constexpr static std::uint64_t numBlocks  = std::uint64_t( 1 ) << max_order;
+    /** the bottom of the tree, each of these covers one bitmap word **/
+    constexpr static std::uint8_t  word_order = 6;
+    constexpr static std::uint64_t numWords   = numBlocks >> word_order;
+
+    /**
+     * there are no leaves here, but callers use the leaf size of the
+     * other heaps as the point past which a request is "large", keep
+     * the same one so switching heaps doesn't change their policy.
+     */
+    constexpr static std::uint16_t blocksize_bits = 512;
+
+    static_assert( max_order < 31, "block offsets have to fit in get_n_blocks' return" );
+    static_assert( max_order >= word_order, "need at least one bitmap word" );
+
+    heap()
+    {
+        self_type::initialize( this );
+    }
+
+    explicit heap( const alloc::uninitialized_t )
+    {
+        /** caller must initialize, see allocheap.hpp **/
+    }
+
+    /**
+     * initialize - same rules as the locked heap, call this exactly
+     * ONCE before anybody else touches the heap.
+     * @param h - self_type - memory to use for heap
+     */
+    static void initialize( self_type *h )
+    {
+        self_type::initialize( h, self_type::numBlocks );
+    }
+
+    /**
+     * initialize - only hand out the first active_blocks, the rest
+     * are marked used once at the top of the tree, nothing under
+     * there is ever written.
+     * @param h - self_type - memory to use for heap
+     * @param active_blocks - blocks actually backed by memory
+     */
+    static void initialize( self_type *h, const std::uint64_t active_blocks )
+    {
+        assert( active_blocks > 0 && active_blocks <= self_type::numBlocks );
+        h->tree[ 1 ] = self_type::max_order + 1;
+        if( active_blocks < self_type::numBlocks )
+        {
+            self_type::assign( h, 1, self_type::max_order, 0,
+                               active_blocks, self_type::numBlocks, false );
+        }
+        h->overall_blocks   = active_blocks;
+        h->total_blocks     = active_blocks;
+    }
+
+    /**
+     * get_total_blocks - blocks this heap was initialized to manage.
+     */
+    static std::size_t get_total_blocks( self_type *h )
+    {
+        return( h->total_blocks );
+    }
+
+    /**
+     * get_n_blocks - return the first of n_blocks contiguous blocks,
+     * -1 if there's no free aligned block big enough. Picks the
+     * smallest free block that fits (best fit), anything past
+     * n_blocks in it stays free.
+     */
+    static std::int32_t get_n_blocks( const std::uint32_t n_blocks, self_type *h )
+    {
+        if( n_blocks == 0 || n_blocks > self_type::numBlocks )
+        {
+            return( -1 );
+        }
+        const auto k = self_type::order_for( n_blocks );
+        if( h->tree[ 1 ] < k + 1 )
+        {
+            return( -1 );
+        }
+        const auto target = std::max( k, self_type::word_order );
+        std::uint64_t   node    = 1;
+        std::uint8_t    order   = self_type::max_order;
+        std::uint64_t   start   = 0;
+        /** stop at the right size or at a free block, either way it fits **/
+        while( order > target && h->tree[ node ] != order + 1 )
+        {
+            const auto l = h->tree[ 2 * node ];
+            const auto r = h->tree[ ( 2 * node ) + 1 ];
+            order--;
+            /** the child with the smaller block that still fits **/
+            if( l >= k + 1 && ( r < k + 1 || l <= r ) )
+            {
+                node = 2 * node;
+            }
+            else
+            {
+                node  = ( 2 * node ) + 1;
+                start += ( std::uint64_t( 1 ) << order );
+            }
+        }
+        if( order == self_type::word_order && h->tree[ node ] != order + 1 )
+        {
+            /** smaller than a word and the word is partly used, look in it **/
+            const auto runs = self_type::aligned_free( ~h->bitmap[ node - self_type::numWords ], k );
+            assert( runs != 0 );
+            start += __builtin_ctzll( runs );
+        }
+        /** 
+         * everything above node was non-uniform on the way down so 
+         * it's safe to just mark under node and fix up the path back.
+         */
+        self_type::assign( h, node, order, start - ( start & ( ( std::uint64_t( 1 ) << order ) - 1 ) ), 
+                           start, start + n_blocks, false );
+        while( node > 1 )
+        {
+            node >>= 1;
+            order++;
+            self_type::pull_up( h, node, order );
+        }
+        h->overall_blocks -= n_blocks;
+        return( static_cast< std::int32_t >( start ) );
+    }
+
+    /**
+     * get_block_multiple - see the locked heap.
+     */
+    static constexpr std::size_t get_block_multiple( const std::size_t nbytes )
+    {
+        const std::size_t multiple = ((nbytes >>  BlockSizePowerTwo ) +
+                               (( nbytes & ((1 << BlockSizePowerTwo ) - 1)
+                                ) != 0 ) );
+        return( multiple );
+    }
+
+    /**
+     * get_blocks_avail - largest free aligned block, there may be
+     * longer free runs that straddle a buddy boundary.
+     */
+    static std::size_t get_blocks_avail( self_type *h )
+    {
+        return( h->tree[ 1 ] == 0 ? 0 : std::size_t( 1 ) << ( h->tree[ 1 ] - 1 ) );
+    }
+
+    /**
+     * return_n_blocks - free any range of blocks, it doesn't have to
+     * be exactly what get_n_blocks handed out (runs get split and
+     * coalesced before they come back), buddies merge on the way up.
+     */
+    static void return_n_blocks( const std::int64_t start_block,
+                                 const std::int64_t n_blocks,
+                                 self_type *h )
+    {
+        assert( start_block >= 0 &&
+                std::uint64_t( start_block + n_blocks ) <= self_type::numBlocks );
+        self_type::assign( h, 1, self_type::max_order, 0,
+                           start_block, start_block + n_blocks, true );
+        h->overall_blocks += n_blocks;
+    }
+
+    /**
+     * get_current_free - total free blocks, see the locked heap.
+     */
+    static std::size_t get_current_free( self_type *h )
+    {
+        return( h->overall_blocks );
+    }
+
+    /**
+     * for_each_free_run - see the locked heap, caller holds the lock.
+     * All free or all used nodes aren't descended into, so this is
+     * only as slow as the heap is fragmented.
+     */
+    template < class F > static void for_each_free_run( self_type *h, F &&f )
+    {
+        helper::free_run_walker< F > walker( f );
+        self_type::walk( h, 1, self_type::max_order, 0, walker );
+        walker.end();
+    }
+
+#ifndef TESTHEAP
+private:
+#endif
+    template < class W > static void walk( self_type           *h,
+                                           const std::uint64_t node,
+                                           const std::uint8_t  order,
+                                           const std::uint64_t node_start,
+                                           W                   &walker )
+    {
+        const auto v = h->tree[ node ];
+        if( v == order + 1 )
+        {
+            walker.add_free( node_start, std::uint64_t( 1 ) << order );
+        }
+        else if( v == 0 )
+        {
+            walker.add_used();
+        }
+        else if( order == self_type::word_order )
+        {
+            walker.add_word( h->bitmap[ node - self_type::numWords ], node_start );
+        }
+        else
+        {
+            const auto half = std::uint64_t( 1 ) << ( order - 1 );
+            self_type::walk( h, 2 * node,         order - 1, node_start,        walker );
+            self_type::walk( h, ( 2 * node ) + 1, order - 1, node_start + half, walker );
+        }
+    }
+
+    /** smallest order with at least n blocks **/
+    static std::uint8_t order_for( const std::uint64_t n )
+    {
+        std::uint8_t k = 0;
+        while( ( std::uint64_t( 1 ) << k ) < n )
+        {
+            k++;
+        }
+        return( k );
+    }
+
+    /**
+     * aligned_free - bit p set if blocks p .. p + 2^k - 1 of the word
+     * are all free and p is a multiple of 2^k, free has a bit set per
+     * free block.
+     */
+    static std::uint64_t aligned_free( std::uint64_t free, const std::uint8_t k )
+    {
+        constexpr std::uint64_t align_mask[ 7 ] = { 
+            0xffffffffffffffff, 0x5555555555555555, 0x1111111111111111,
+            0x0101010101010101, 0x0001000100010001, 0x0000000100000001,
+            0x0000000000000001 };
+        for( std::uint8_t i( 0 ); i < k; i++ )
+        {
+            free &= ( free >> ( 1 << i ) );
+        }
+        return( free & align_mask[ k ] );
+    }
+
+    /** word_value - tree value for a word node from its bitmap **/
+    static std::uint8_t word_value( const std::uint64_t word )
+    {
+        for( std::int8_t k( self_type::word_order ); k >= 0; k-- )
+        {
+            if( self_type::aligned_free( ~word, k ) != 0 )
+            {
+                return( k + 1 );
+            }
+        }
+        return( 0 );
+    }
+
+    /**
+     * push_down - an all free or all used node says the same about
+     * everything under it, write that into the children (or the word,
+     * at the bottom) before looking below it.
+     */
+    static void push_down( self_type *h, const std::uint64_t node, const std::uint8_t order )
+    {
+        const auto v = h->tree[ node ];
+        if( v != 0 && v != order + 1 )
+        {
+            return;
+        }
+        if( order == self_type::word_order )
+        {
+            h->bitmap[ node - self_type::numWords ] = ( v == 0 ? ~std::uint64_t( 0 ) : 0 );
+            return;
+        }
+        /** a free child of order - 1 is order **/
+        const std::uint8_t child = ( v == 0 ? 0 : order );
+        h->tree[ 2 * node ]         = child;
+        h->tree[ ( 2 * node ) + 1 ] = child;
+    }
+
+    /** pull_up - recompute a node from its children, buddies merge here **/
+    static void pull_up( self_type *h, const std::uint64_t node, const std::uint8_t order )
+    {
+        const auto l = h->tree[ 2 * node ];
+        const auto r = h->tree[ ( 2 * node ) + 1 ];
+        h->tree[ node ] = ( l == order && r == order ? order + 1 : std::max( l, r ) );
+    }
+
+    /**
+     * assign - mark [lo, hi) free or used under node, which covers
+     * 2^order blocks from node_start. Touches O(log n) nodes.
+     */
+    static void assign( self_type           *h,
+                        const std::uint64_t node,
+                        const std::uint8_t  order,
+                        const std::uint64_t node_start,
+                        const std::uint64_t lo,
+                        const std::uint64_t hi,
+                        const bool          free )
+    {
+        const auto node_end = node_start + ( std::uint64_t( 1 ) << order );
+        if( hi <= node_start || lo >= node_end )
+        {
+            return;
+        }
+        if( lo <= node_start && node_end <= hi )
+        {
+            h->tree[ node ] = ( free ? order + 1 : 0 );
+            return;
+        }
+        self_type::push_down( h, node, order );
+        if( order == self_type::word_order )
+        {
+            const auto first = std::max( lo, node_start ) - node_start;
+            const auto last  = std::min( hi, node_end ) - node_start;
+            const auto bits  = ( last - first == 64 ? ~std::uint64_t( 0 ) : 
+                                 ( ( std::uint64_t( 1 ) << ( last - first ) ) - 1 ) ) << first;
+            auto &word = h->bitmap[ node - self_type::numWords ];
+            word = ( free ? word & ~bits : word | bits );
+            h->tree[ node ] = self_type::word_value( word );
+            return;
+        }
+        const auto half = std::uint64_t( 1 ) << ( order - 1 );
+        self_type::assign( h, 2 * node,         order - 1, node_start,          lo, hi, free );
+        self_type::assign( h, ( 2 * node ) + 1, order - 1, node_start + half,   lo, hi, free );
+        self_type::pull_up( h, node, order );
+    }
+
+//data
+    std::size_t     overall_blocks  = 0;
+    std::size_t     total_blocks    = 0;
+    /** 
+     * 1 based, node i has children 2i and 2i + 1, tree[ 0 ] unused, 
+     * nodes numWords and up are the bottom, node i covers bitmap word
+     * i - numWords, bit b of a word is its block b, set when used.
+     */
+    std::uint8_t    tree[ 2 * numWords ];
+    std::uint64_t   bitmap[ numWords ];
+};
+
+} /** end namespace alloc **/
+
+#endif /* END BUDDYHEAP_HPP */
@@ -82,6 +82,68 @@ find_longest_contiguous_zeros( std::uint64_t val  )
     return( std::make_pair( maxLen, returnOffset )  );
 } 
 
+/**
+ * free_run_walker - the heaps' for_each_free_run feed this their
+ * bitmaps (set bit == used, bit 0 is the lowest block) in block order
+ * and it calls f( start_block, length ) once for every maximal free
+ * run, runs carry across words and leaves, call end() when done.
+ */
+template < class F > struct free_run_walker
+{
+    explicit free_run_walker( F &func ) : f( func ){}
+
+    void add_word( const std::uint64_t used, const std::uint64_t base )
+    {
+        std::uint32_t p = 0;
+        while( p < 64 )
+        {
+            const auto rest = used >> p;
+            if( ( rest & 1 ) == 0 )
+            {
+                const std::uint32_t len = ( rest == 0 ? 64 - p : __builtin_ctzll( rest ) );
+                add_free( base + p, len );
+                p += len;
+            }
+            else
+            {
+                const std::uint32_t len = ( ~rest == 0 ? 64 - p : __builtin_ctzll( ~rest ) );
+                add_used();
+                p += len;
+            }
+        }
+    }
+
+    void add_free( const std::uint64_t start, const std::uint64_t len )
+    {
+        if( run_len != 0 && run_start + run_len == start )
+        {
+            run_len += len;
+            return;
+        }
+        add_used();
+        run_start   = start;
+        run_len     = len;
+    }
+
+    void add_used()
+    {
+        if( run_len != 0 )
+        {
+            f( run_start, run_len );
+            run_len = 0;
+        }
+    }
+
+    void end()
+    {
+        add_used();
+    }
+
+    F               &f;
+    std::uint64_t   run_start   = 0;
+    std::uint64_t   run_len     = 0;
+};
+
 } /** end namespace helper **/
 
 #endif /** end HELPER **/
@@ -0,0 +1,424 @@
+/**
+ * lockfreeheap.hpp - concurrent version of the block heap, selected
+ * with alloc::heap< total, block, alloc::lock_free >. The leaves are
+ * the same 512 bit vectors as the locked heap, but blocks are claimed
+ * with CAS directly on the 64b words of the leaf, so there is no
+ * global lock. Instead of the priority heap ordered on contiguous
+ * free blocks there is a per-leaf hint of the longest free run which
+ * is refreshed after every claim and return. Hints may be stale under
+ * contention, they're only used to skip leaves, a leaf is always
+ * re-checked against its actual bits before anything is claimed.
+ *
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 13:20:47 2026
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LOCKFREEHEAP_HPP
+#define LOCKFREEHEAP_HPP  1
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <utility>
+#include "_512bits.hpp"
+#include "helper.hpp"
+
+namespace alloc
+{
+
+template < int TotalMemSizePowerTwo,
+           int BlockSizePowerTwo >
+#ifdef TESTHEAP
+           struct
+#else
+           class
+#endif
+           heap< TotalMemSizePowerTwo, BlockSizePowerTwo, alloc::lock_free >
+{
+#ifndef TESTHEAP
+public:
+#endif
+
+    using self_type = heap< TotalMemSizePowerTwo, BlockSizePowerTwo, alloc::lock_free >;
+    using range_t   = std::pair< std::int32_t, std::int32_t >;
+
+    /** safe to call from any number of threads/processes without a lock **/
+    constexpr static bool is_lock_free = true;
+
+    constexpr static std::uint8_t blocksize_pow_two  = 9;
+    constexpr static std::uint16_t blocksize_bits    = (1<<blocksize_pow_two);
+    constexpr static std::uint64_t numElements =
+        1 << ( TotalMemSizePowerTwo - 9 /** 512 **/ - BlockSizePowerTwo );
+
+    heap()
+    {
+        self_type::initialize( this );
+    }
+
+    explicit heap( const alloc::uninitialized_t )
+    {
+        /** caller must initialize, see allocheap.hpp **/
+    }
+
+    /**
+     * initialize - same rules as the locked heap, call this exactly
+     * ONCE before anybody else touches the heap.
+     * @param h - self_type - memory to use for heap
+     */
+    static void initialize( self_type *h )
+    {
+        self_type::initialize( h, self_type::blocksize_bits * self_type::numElements );
+    }
+
+    /**
+     * initialize - only hand out the first active_blocks, see the
+     * locked heap. Leaves past the active ones are never searched.
+     * @param h - self_type - memory to use for heap
+     * @param active_blocks - blocks actually backed by memory
+     */
+    static void initialize( self_type *h, const std::uint64_t active_blocks )
+    {
+        assert( active_blocks > 0 && 
+                active_blocks <= self_type::blocksize_bits * self_type::numElements );
+        h->active_leaves = ( active_blocks + self_type::blocksize_bits - 1 ) / 
+                                self_type::blocksize_bits;
+        /** leaves past the active ones are never looked at, leave them **/
+        std::memset( &h->offsetArray, 0x0, sizeof( _512bits ) * h->active_leaves );
+        for( std::uint64_t i( 0 ); i < h->active_leaves; i++ )
+        {
+            h->hint[ i ] = self_type::blocksize_bits;
+        }
+        const std::uint16_t tail = active_blocks % self_type::blocksize_bits;
+        if( tail != 0 )
+        {
+            _512bits::set_range( tail, 
+                                 self_type::blocksize_bits, 
+                                 &h->offsetArray[ h->active_leaves - 1 ] );
+            h->hint[ h->active_leaves - 1 ] = tail;
+        }
+        h->overall_blocks   = active_blocks;
+        h->total_blocks     = active_blocks;
+        h->cursor           = 0;
+    }
+
+    /**
+     * get_total_blocks - blocks this heap was initialized to manage.
+     */
+    static std::size_t get_total_blocks( self_type *h )
+    {
+        return( h->total_blocks );
+    }
+
+    /**
+     * get_n_blocks - return offset with start + n_blocks of contiguous
+     * storage that you can allocate, -1 if nothing is available. The
+     * first pass only looks at leaves whose hint says they might fit,
+     * if that comes up empty a second pass checks every leaf given the
+     * hints could have been left stale by a racing update.
+     */
+    static std::int32_t get_n_blocks( const std::uint32_t n_blocks, self_type *h )
+    {
+        if( n_blocks == 0 )
+        {
+            return( -1 );
+        }
+        if( n_blocks > self_type::blocksize_bits )
+        {
+            return( self_type::get_span( n_blocks, h ) );
+        }
+        const auto start = __atomic_load_n( &h->cursor, __ATOMIC_RELAXED );
+        for( int pass( 0 ); pass < 2; pass++ )
+        {
+            for( std::uint64_t i( 0 ); i < h->active_leaves; i++ )
+            {
+                auto leaf = start + i;
+                if( leaf >= h->active_leaves )
+                {
+                    leaf -= h->active_leaves;
+                }
+                if( pass == 0 &&
+                    __atomic_load_n( &h->hint[ leaf ], __ATOMIC_RELAXED ) < n_blocks )
+                {
+                    continue;
+                }
+                const auto offset = self_type::claim( leaf, n_blocks, h );
+                if( offset >= 0 )
+                {
+                    __atomic_store_n( &h->cursor, leaf, __ATOMIC_RELAXED );
+                    __atomic_fetch_sub( &h->overall_blocks, n_blocks, __ATOMIC_RELAXED );
+                    return( ( leaf * self_type::blocksize_bits ) + offset );
+                }
+            }
+        }
+        return( -1 );
+    }
+
+    /**
+     * get_block_multiple - see locked heap, identical.
+     */
+    static constexpr std::size_t get_block_multiple( const std::size_t nbytes )
+    {
+        const std::size_t multiple = ((nbytes >>  BlockSizePowerTwo ) +
+                               (( nbytes & ((1 << BlockSizePowerTwo ) - 1)
+                                ) != 0 ) );
+        return( multiple );
+    }
+
+    /**
+     * get_blocks_avail - largest hint over all leaves. This is a
+     * snapshot, another thread can claim it before you get to it
+     * so always check the return of get_n_blocks.
+     */
+    static std::size_t get_blocks_avail( self_type *h )
+    {
+        std::uint16_t max_hint = 0;
+        for( std::uint64_t i( 0 ); i < h->active_leaves; i++ )
+        {
+            max_hint = std::max( max_hint,
+                                 __atomic_load_n( &h->hint[ i ], __ATOMIC_RELAXED ) );
+        }
+        return( max_hint );
+    }
+
+    /**
+     * return_n_blocks - put the blocks back, same contract as the
+     * locked heap, bits are cleared with an atomic and on each word
+     * then the leaf hint is refreshed.
+     */
+    static void return_n_blocks( const std::int64_t start_block,
+                                 const std::int64_t n_blocks,
+                                 self_type *h )
+    {
+        std::int64_t block      = start_block;
+        std::int64_t remaining  = n_blocks;
+        while( remaining > 0 )
+        {
+            const auto leaf         = block / self_type::blocksize_bits;
+            const auto offset_start = block % self_type::blocksize_bits;
+            const auto len = std::min< std::int64_t >( remaining,
+                                                       self_type::blocksize_bits - offset_start );
+            self_type::clear_range( leaf, offset_start, offset_start + len, h );
+            self_type::refresh_hint( leaf, h );
+            block       += len;
+            remaining   -= len;
+        }
+        __atomic_fetch_add( &h->overall_blocks, n_blocks, __ATOMIC_RELAXED );
+    }
+
+    /**
+     * get_current_free - total number of free blocks, not
+     * necessarily contiguous.
+     */
+    static std::size_t get_current_free( self_type *h )
+    {
+        return( __atomic_load_n( &h->overall_blocks, __ATOMIC_RELAXED ) );
+    }
+
+    /**
+     * for_each_free_run - see the locked heap, here it's a snapshot
+     * that may be torn by concurrent claims/returns, fine for stats.
+     */
+    template < class F > static void for_each_free_run( self_type *h, F &&f )
+    {
+        helper::free_run_walker< F > walker( f );
+        for( std::uint64_t leaf( 0 ); leaf < h->active_leaves; leaf++ )
+        {
+            for( std::uint8_t w( 0 ); w < _512bits::n_words; w++ )
+            {
+                walker.add_word( __atomic_load_n( _512bits::get_word( w, &h->offsetArray[ leaf ] ),
+                                                  __ATOMIC_RELAXED ),
+                                 ( leaf * self_type::blocksize_bits ) + 
+                                    ( w * _512bits::word_bits ) );
+            }
+        }
+        walker.end();
+    }
+
+#ifndef TESTHEAP
+private:
+#endif
+
+    /**
+     * snapshot - copy the leaf a word at a time, each word is
+     * consistent but the copy as a whole may not be.
+     */
+    static void snapshot( const std::uint64_t leaf, _512bits &out, self_type *h )
+    {
+        for( std::uint8_t w( 0 ); w < _512bits::n_words; w++ )
+        {
+            *_512bits::get_word( w, &out ) =
+                __atomic_load_n( _512bits::get_word( w, &h->offsetArray[ leaf ] ),
+                                 __ATOMIC_ACQUIRE );
+        }
+    }
+
+    static range_t refresh_hint( const std::uint64_t leaf, self_type *h )
+    {
+        _512bits copy;
+        self_type::snapshot( leaf, copy, h );
+        const auto range = _512bits::find_longest_contiguous_zeros( &copy );
+        __atomic_store_n( &h->hint[ leaf ],
+                          static_cast< std::uint16_t >( range.first ),
+                          __ATOMIC_RELAXED );
+        return( range );
+    }
+
+    /**
+     * get_span - same layout as the locked heap's spans, starts at
+     * the front of a leaf, all leaves but the last fully claimed. 
+     * Leaves are claimed in order, if any of them is lost to a racing
+     * allocation everything claimed so far is given back and the
+     * search carries on past the leaf that failed.
+     */
+    static std::int32_t get_span( const std::uint32_t n_blocks, self_type *h )
+    {
+        const std::uint64_t full_leaves = n_blocks / self_type::blocksize_bits;
+        const std::uint16_t tail        = n_blocks % self_type::blocksize_bits;
+        const std::uint64_t n_leaves    = full_leaves + ( tail != 0 ? 1 : 0 );
+        if( n_leaves > h->active_leaves )
+        {
+            return( -1 );
+        }
+        std::uint64_t first = 0;
+        while( first + n_leaves <= h->active_leaves )
+        {
+            std::uint64_t claimed = 0;
+            for( ; claimed < n_leaves; claimed++ )
+            {
+                const auto leaf = first + claimed;
+                const std::uint16_t len = ( claimed == full_leaves ? 
+                                            tail : self_type::blocksize_bits );
+                if( ! self_type::try_set_range( leaf, 0, len, h ) )
+                {
+                    break;
+                }
+            }
+            if( claimed == n_leaves )
+            {
+                for( auto l( first ); l < first + n_leaves; l++ )
+                {
+                    self_type::refresh_hint( l, h );
+                }
+                __atomic_fetch_sub( &h->overall_blocks, n_blocks, __ATOMIC_RELAXED );
+                return( first * self_type::blocksize_bits );
+            }
+            //roll back the leaves we did get, all of them full ones
+            for( std::uint64_t l( 0 ); l < claimed; l++ )
+            {
+                self_type::clear_range( first + l, 0, self_type::blocksize_bits, h );
+            }
+            first += claimed + 1;
+        }
+        return( -1 );
+    }
+
+    /**
+     * claim - find and set n_blocks contiguous bits within leaf,
+     * retries as long as the leaf still has a long enough run, each
+     * retry means somebody else made progress.
+     * @return offset within the leaf or -1 if it doesn't fit.
+     */
+    static std::int32_t claim( const std::uint64_t leaf,
+                               const std::uint32_t n_blocks,
+                               self_type *h )
+    {
+        for( ;; )
+        {
+            const auto range = self_type::refresh_hint( leaf, h );
+            if( range.first < static_cast< std::int32_t >( n_blocks ) )
+            {
+                return( -1 );
+            }
+            if( self_type::try_set_range( leaf, range.second, range.second + n_blocks, h ) )
+            {
+                self_type::refresh_hint( leaf, h );
+                return( range.second );
+            }
+        }
+    }
+
+    /**
+     * try_set_range - set bits [start, end) word by word from low to
+     * high, if any of them are already set somebody beat us to it, so
+     * clear whatever we've set so far and report failure.
+     */
+    static bool try_set_range( const std::uint64_t leaf,
+                               const std::uint16_t start,
+                               const std::uint16_t end,
+                               self_type *h )
+    {
+        std::uint16_t bit = start;
+        while( bit < end )
+        {
+            const std::uint8_t  w       = bit / _512bits::word_bits;
+            const std::uint16_t base    = w * _512bits::word_bits;
+            const std::uint16_t hi      = std::min< std::uint16_t >( end - base,
+                                                                     _512bits::word_bits );
+            const auto mask  = _512bits::range_mask( bit - base, hi );
+            auto *word       = _512bits::get_word( w, &h->offsetArray[ leaf ] );
+            auto expected    = __atomic_load_n( word, __ATOMIC_ACQUIRE );
+            do
+            {
+                if( ( expected & mask ) != 0 )
+                {
+                    self_type::clear_range( leaf, start, bit, h );
+                    return( false );
+                }
+            }while( ! __atomic_compare_exchange_n( word,
+                                                   &expected,
+                                                   expected | mask,
+                                                   true /** weak **/,
+                                                   __ATOMIC_ACQ_REL,
+                                                   __ATOMIC_ACQUIRE ) );
+            bit = base + hi;
+        }
+        return( true );
+    }
+
+    /**
+     * clear_range - clear bits [start, end), caller must own them.
+     */
+    static void clear_range( const std::uint64_t leaf,
+                             const std::uint16_t start,
+                             const std::uint16_t end,
+                             self_type *h )
+    {
+        std::uint16_t bit = start;
+        while( bit < end )
+        {
+            const std::uint8_t  w       = bit / _512bits::word_bits;
+            const std::uint16_t base    = w * _512bits::word_bits;
+            const std::uint16_t hi      = std::min< std::uint16_t >( end - base,
+                                                                     _512bits::word_bits );
+            __atomic_fetch_and( _512bits::get_word( w, &h->offsetArray[ leaf ] ),
+                                ~_512bits::range_mask( bit - base, hi ),
+                                __ATOMIC_RELEASE );
+            bit = base + hi;
+        }
+    }
+
+//data
+    alignas( 64 ) _512bits      offsetArray[ numElements ];
+    /** longest free run within each leaf, may be stale **/
+    alignas( 64 ) std::uint16_t hint[ numElements ];
+    /** last leaf we allocated from, start looking there **/
+    alignas( 64 ) std::uint64_t cursor          = 0;
+    alignas( 64 ) std::size_t   overall_blocks  = 0;
+    /** set once by initialize, read only after **/
+    std::uint64_t               active_leaves   = numElements;
+    std::size_t                 total_blocks    = 0;
+};
+
+} /** end namespace alloc **/
+
+#endif /* END LOCKFREEHEAP_HPP */
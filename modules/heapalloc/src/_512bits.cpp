@@ -19,7 +19,7 @@
 #include <cassert>
 
 std::uint16_t 
-alloc::_512bits::total_bits_set( _512bits *f )
+alloc::_512bits::total_bits_set_generic( _512bits *f )
 {
     return( __builtin_popcountl( f->_000_063 ) + 
             __builtin_popcountl( f->_064_127 ) +
@@ -33,9 +33,9 @@ alloc::_512bits::total_bits_set( _512bits *f )
     
 
 std::pair< std::int32_t, std::int32_t > 
-alloc::_512bits::find_longest_contiguous_zeros( _512bits *f )
+alloc::_512bits::find_longest_contiguous_zeros_generic( _512bits *f )
 {
-    const auto total_bits_flipped = _512bits::total_bits_set( f );
+    const auto total_bits_flipped = _512bits::total_bits_set_generic( f );
     if(  total_bits_flipped == 512 )
     {
         return( std::make_pair( 0 /** longest stretch **/, 0 /** offset of setretch **/) );
@@ -153,38 +153,38 @@ alloc::_512bits::set_bit( std::uint16_t x, _512bits *f )
 {
     if( x < 64 )
     {
-       f->_000_063 |= (1ULL << x);
+       f->_000_063 |= (1ULL << (x & 63));
     }
     else if( x < 128 )
     {
-        f->_064_127 |= (1ULL << x);
+        f->_064_127 |= (1ULL << (x & 63));
 
     }
     else if( x < 192 )
     {
-        f->_128_191 |= (1ULL << x);
+        f->_128_191 |= (1ULL << (x & 63));
     }
     else if( x < 256 )
     {
-        f->_192_255 |= (1ULL << x);
+        f->_192_255 |= (1ULL << (x & 63));
     }
     else if( x < 320 )
     {
-        f->_256_319 |= (1ULL << x);
+        f->_256_319 |= (1ULL << (x & 63));
     }
     else if( x < 384 )
     {
-        f->_320_383 |= (1ULL << x);
+        f->_320_383 |= (1ULL << (x & 63));
 
     }
     else if( x < 448 )
     {
-        f->_384_447 |= (1ULL << x);
+        f->_384_447 |= (1ULL << (x & 63));
 
     }
     else if( x < 512 )
     {
-        f->_448_511 |= (1ULL << x);
+        f->_448_511 |= (1ULL << (x & 63));
     }
     return;
 }
@@ -194,36 +194,98 @@ alloc::_512bits::unset_bit( std::uint16_t x, _512bits *f )
 {
     if( x < 64 )
     {
-       f->_000_063 &= ~(1ULL << x);
+       f->_000_063 &= ~(1ULL << (x & 63));
     }
     else if( x < 128 )
     {
-        f->_064_127 &= ~(1ULL << x);
+        f->_064_127 &= ~(1ULL << (x & 63));
 
     }
     else if( x < 192 )
     {
-        f->_128_191 &= ~(1ULL << x);
+        f->_128_191 &= ~(1ULL << (x & 63));
     }
     else if( x < 256 )
     {
-        f->_192_255 &= ~(1ULL << x);
+        f->_192_255 &= ~(1ULL << (x & 63));
     }
     else if( x < 320 )
     {
-        f->_256_319 &= ~(1ULL << x);
+        f->_256_319 &= ~(1ULL << (x & 63));
     }
     else if( x < 384 )
     {
-        f->_320_383 &= ~(1ULL << x);
+        f->_320_383 &= ~(1ULL << (x & 63));
     }
     else if( x < 448 )
     {
-        f->_384_447 &= ~(1ULL << x);
+        f->_384_447 &= ~(1ULL << (x & 63));
     }
     else if( x < 512 )
     {
-        f->_448_511 &= ~(1ULL << x);
+        f->_448_511 &= ~(1ULL << (x & 63));
     }
     return;
 }
+
+std::uint64_t* 
+alloc::_512bits::get_word( std::uint8_t index, _512bits *f )
+{
+    switch( index )
+    {
+        case( 0 ): return( &f->_000_063 );
+        case( 1 ): return( &f->_064_127 );
+        case( 2 ): return( &f->_128_191 );
+        case( 3 ): return( &f->_192_255 );
+        case( 4 ): return( &f->_256_319 );
+        case( 5 ): return( &f->_320_383 );
+        case( 6 ): return( &f->_384_447 );
+        case( 7 ): return( &f->_448_511 );
+        default:
+            assert( false );
+    }
+    return( nullptr );
+}
+
+void
+alloc::_512bits::set_range( std::uint16_t start, const std::uint16_t end, _512bits *f )
+{
+    while( start < end )
+    {
+        const std::uint8_t  w       = start / word_bits;
+        const std::uint16_t base    = w * word_bits;
+        const std::uint16_t hi      = std::min< std::uint16_t >( end - base, word_bits );
+        *_512bits::get_word( w, f ) |= _512bits::range_mask( start - base, hi );
+        start = base + hi;
+    }
+}
+
+void
+alloc::_512bits::unset_range( std::uint16_t start, const std::uint16_t end, _512bits *f )
+{
+    while( start < end )
+    {
+        const std::uint8_t  w       = start / word_bits;
+        const std::uint16_t base    = w * word_bits;
+        const std::uint16_t hi      = std::min< std::uint16_t >( end - base, word_bits );
+        *_512bits::get_word( w, f ) &= ~_512bits::range_mask( start - base, hi );
+        start = base + hi;
+    }
+}
+
+bool
+alloc::_512bits::is_range_unset( std::uint16_t start, const std::uint16_t end, _512bits *f )
+{
+    while( start < end )
+    {
+        const std::uint8_t  w       = start / word_bits;
+        const std::uint16_t base    = w * word_bits;
+        const std::uint16_t hi      = std::min< std::uint16_t >( end - base, word_bits );
+        if( ( *_512bits::get_word( w, f ) & _512bits::range_mask( start - base, hi ) ) != 0 )
+        {
+            return( false );
+        }
+        start = base + hi;
+    }
+    return( true );
+}
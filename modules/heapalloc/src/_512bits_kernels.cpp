@@ -0,0 +1,502 @@
+/**
+ * _512bits_kernels.cpp - ISA specific versions of the _512bits scans
+ * and the runtime dispatch between them. Everything that needs a
+ * particular x86 extension is compiled with a target attribute so
+ * the rest of the library stays baseline, the dispatch checks CPUID
+ * before any of them are called.
+ *
+ * The vector kernels find the longest zero run without walking the
+ * bits. With Z = ~bits and E_k the set of positions i where bits
+ * ( i - 2^k, i ] are all zero:
+ *   E_0 = Z, E_k = E_{k-1} & ( E_{k-1} << 2^{k-1} )
+ * the longest run is then built greedily from the largest power of
+ * two down, keeping the set of positions where a zero run of the
+ * current length ends, starting with cur = the largest non-empty E_k:
+ *   cand = E_k & ( cur << 2^k ), if cand != 0 then cur = cand, len += 2^k
+ * Every shift is by a constant and all 512b are processed at once.
+ *
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 15:02:11 2026
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "_512bits.hpp"
+#include <cstring>
+#include <cassert>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define HEAPALLOC_X86 1
+/** 
+ * gcc 12 flags _mm512_undefined_* inside its own headers as 
+ * uninitialized use, nothing we can do about that here.
+ */
+#if defined( __GNUC__ ) && ! defined( __clang__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined( __GNUC__ ) && ! defined( __clang__ )
+#pragma GCC diagnostic pop
+#endif
+#else
+#define HEAPALLOC_X86 0
+#endif
+
+static_assert( sizeof( alloc::_512bits ) == 64, "_512bits must be exactly 8 words" );
+
+using range_t = std::pair< std::int32_t, std::int32_t >;
+
+namespace
+{
+
+/** bits [0, n), 0 <= n <= 64 **/
+inline std::uint64_t low_mask( const int n )
+{
+    return( n == 64 ? ~0ULL : ( 1ULL << n ) - 1 );
+}
+
+/**
+ * highest_run_end - given the final set of run end positions as
+ * 8 words, the run at the highest offset wins ties.
+ */
+inline range_t highest_run( const std::uint64_t ends[ 8 ], const std::int32_t len )
+{
+    for( int w( 7 ); w >= 0; w-- )
+    {
+        if( ends[ w ] != 0 )
+        {
+            const std::int32_t end = ( w * 64 ) + ( 63 - __builtin_clzll( ends[ w ] ) );
+            return( std::make_pair( len, end - len + 1 ) );
+        }
+    }
+    assert( false );
+    return( std::make_pair( 0, 0 ) );
+}
+
+struct dispatch_t
+{
+    std::uint16_t   (*total_bits_set)( alloc::_512bits* )  = alloc::_512bits::total_bits_set_generic;
+    range_t         (*longest_zeros)( alloc::_512bits* )   = alloc::_512bits::find_longest_contiguous_zeros_generic;
+    alloc::_512bits::kernel k                              = alloc::_512bits::generic;
+};
+
+#if HEAPALLOC_X86
+
+/**
+ * scalar - popcnt + tzcnt, walks one run at a time rather than one
+ * bit at a time.
+ */
+__attribute__(( target( "popcnt" ) ))
+std::uint16_t total_bits_set_scalar( alloc::_512bits *f )
+{
+    std::uint64_t w[ 8 ];
+    std::memcpy( w, f, sizeof( w ) );
+    std::uint16_t count = 0;
+    for( int i( 0 ); i < 8; i++ )
+    {
+        count += __builtin_popcountll( w[ i ] );
+    }
+    return( count );
+}
+
+__attribute__(( target( "popcnt,bmi" ) ))
+range_t find_longest_contiguous_zeros_scalar( alloc::_512bits *f )
+{
+    std::uint64_t words[ 8 ];
+    std::memcpy( words, f, sizeof( words ) );
+
+    std::int32_t    currLen         =   0,
+                    currOffset      =   0,
+                    maxLen          =   0,
+                    maxOffsetStart  =   0;
+    /** 
+     * walk up from bit 0, ties go to the run found last (highest
+     * offset) to match the generic version which walks down.
+     */
+    for( int w( 0 ); w < 8; w++ )
+    {
+        const auto          val  = words[ w ];
+        const std::int32_t  base = w * 64;
+        /** bits [bottom, 64) of this word are still to be looked at **/
+        int bottom = 0;
+        while( bottom < 64 )
+        {
+            const auto ones = val & ~low_mask( bottom );
+            const int  next_one = ( ones == 0 ? 64 : __builtin_ctzll( ones ) );
+            if( next_one > bottom )
+            {
+                if( currLen == 0 )
+                {
+                    currOffset = base + bottom;
+                }
+                currLen += next_one - bottom;
+            }
+            if( next_one == 64 )
+            {
+                /** zeros all the way up, run continues into next word **/
+                break;
+            }
+            if( currLen > 0 && currLen >= maxLen )
+            {
+                maxLen          = currLen;
+                maxOffsetStart  = currOffset;
+            }
+            currLen = 0;
+            /** skip over the ones **/
+            const auto zeros = ~val & ~low_mask( next_one + 1 );
+            bottom = ( zeros == 0 ? 64 : __builtin_ctzll( zeros ) );
+        }
+    }
+    if( currLen > 0 && currLen >= maxLen )
+    {
+        maxLen          = currLen;
+        maxOffsetStart  = currOffset;
+    }
+    return( std::make_pair( maxLen, maxOffsetStart ) );
+}
+
+/**
+ * avx2 - 512b held as two 256b halves, lo = words 0-3, hi = words 4-7.
+ */
+struct v512_avx2
+{
+    __m256i lo;
+    __m256i hi;
+};
+
+/** shift up by Q words, Q in { 1, 2, 4 } **/
+template < int Q > __attribute__(( target( "avx2" ) ))
+inline v512_avx2 shl_words_avx2( const v512_avx2 v )
+{
+    const auto zero = _mm256_setzero_si256();
+    if constexpr( Q == 4 )
+    {
+        return( v512_avx2{ zero, v.lo } );
+    }
+    else if constexpr( Q == 2 )
+    {
+        return( v512_avx2{ _mm256_permute2x128_si256( v.lo, v.lo, 0x08 ),
+                  _mm256_permute2x128_si256( v.lo, v.hi, 0x21 ) } );
+    }
+    else
+    {
+        static_assert( Q == 1, "unsupported word shift" );
+        const auto lo = _mm256_permute4x64_epi64( v.lo, _MM_SHUFFLE( 2, 1, 0, 0 ) );
+        const auto hi = _mm256_permute4x64_epi64( v.hi, _MM_SHUFFLE( 2, 1, 0, 0 ) );
+        const auto carry = _mm256_permute4x64_epi64( v.lo, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        return( v512_avx2{ _mm256_blend_epi32( lo, zero, 0x03 ),
+                  _mm256_blend_epi32( hi, carry, 0x03 ) } );
+    }
+}
+
+/** shift the whole 512b up (towards bit 511) by S, S a power of two **/
+template < int S > __attribute__(( target( "avx2" ) ))
+inline v512_avx2 shl_avx2( const v512_avx2 v )
+{
+    static_assert( ( S & ( S - 1 ) ) == 0 && S <= 256, "S must be a power of two <= 256" );
+    if constexpr( S >= 64 )
+    {
+        return( shl_words_avx2< S / 64 >( v ) );
+    }
+    else
+    {
+        const auto prev = shl_words_avx2< 1 >( v );
+        return( v512_avx2{ _mm256_or_si256( _mm256_slli_epi64( v.lo, S ),
+                                   _mm256_srli_epi64( prev.lo, 64 - S ) ),
+                  _mm256_or_si256( _mm256_slli_epi64( v.hi, S ),
+                                   _mm256_srli_epi64( prev.hi, 64 - S ) ) } );
+    }
+}
+
+__attribute__(( target( "avx2" ) ))
+inline v512_avx2 and_avx2( const v512_avx2 a, const v512_avx2 b )
+{
+    return( v512_avx2{ _mm256_and_si256( a.lo, b.lo ), _mm256_and_si256( a.hi, b.hi ) } );
+}
+
+__attribute__(( target( "avx2" ) ))
+inline bool any_avx2( const v512_avx2 a )
+{
+    return( ! _mm256_testz_si256( a.lo, a.lo ) || ! _mm256_testz_si256( a.hi, a.hi ) );
+}
+
+template < int K > __attribute__(( target( "avx2" ) ))
+inline void build_ends_avx2( v512_avx2 e[ 9 ] )
+{
+    if constexpr( K <= 8 )
+    {
+        e[ K ] = and_avx2( e[ K - 1 ], shl_avx2< ( 1 << ( K - 1 ) ) >( e[ K - 1 ] ) );
+        build_ends_avx2< K + 1 >( e );
+    }
+}
+
+template < int K > __attribute__(( target( "avx2" ) ))
+inline void grow_run_avx2( const v512_avx2 e[ 9 ], v512_avx2 &cur, std::int32_t &len )
+{
+    if constexpr( K >= 0 )
+    {
+        const auto cand = ( len == 0 ? e[ K ] : 
+                                       and_avx2( e[ K ], shl_avx2< ( 1 << K ) >( cur ) ) );
+        if( any_avx2( cand ) )
+        {
+            cur  = cand;
+            len += ( 1 << K );
+        }
+        grow_run_avx2< K - 1 >( e, cur, len );
+    }
+}
+
+__attribute__(( target( "avx2,popcnt" ) ))
+std::uint16_t total_bits_set_avx2( alloc::_512bits *f )
+{
+    /** nibble lookup popcount, summed per 64b lane with sad **/
+    const auto lut  = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+    const auto low  = _mm256_set1_epi8( 0x0f );
+    const auto zero = _mm256_setzero_si256();
+    const auto *p   = reinterpret_cast< const __m256i* >( f );
+    __m256i sum     = zero;
+    for( int i( 0 ); i < 2; i++ )
+    {
+        const auto v    = _mm256_loadu_si256( p + i );
+        const auto cnt  = _mm256_add_epi8(
+            _mm256_shuffle_epi8( lut, _mm256_and_si256( v, low ) ),
+            _mm256_shuffle_epi8( lut, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), low ) ) );
+        sum = _mm256_add_epi64( sum, _mm256_sad_epu8( cnt, zero ) );
+    }
+    const auto half = _mm_add_epi64( _mm256_castsi256_si128( sum ),
+                                     _mm256_extracti128_si256( sum, 1 ) );
+    return( static_cast< std::uint16_t >( _mm_cvtsi128_si64( half ) +
+                                          _mm_extract_epi64( half, 1 ) ) );
+}
+
+__attribute__(( target( "avx2" ) ))
+range_t find_longest_contiguous_zeros_avx2( alloc::_512bits *f )
+{
+    const auto *p    = reinterpret_cast< const __m256i* >( f );
+    const auto ones  = _mm256_set1_epi64x( -1 );
+    v512_avx2 e[ 9 ];
+    e[ 0 ] = { _mm256_xor_si256( _mm256_loadu_si256( p     ), ones ),
+               _mm256_xor_si256( _mm256_loadu_si256( p + 1 ), ones ) };
+    if( ! any_avx2( e[ 0 ] ) )
+    {
+        return( std::make_pair( 0, 0 ) );
+    }
+    if( _mm256_testc_si256( e[ 0 ].lo, ones ) && _mm256_testc_si256( e[ 0 ].hi, ones ) )
+    {
+        return( std::make_pair( 512, 0 ) );
+    }
+    build_ends_avx2< 1 >( e );
+
+    v512_avx2       cur = e[ 0 ];
+    std::int32_t    len = 0;
+    grow_run_avx2< 8 >( e, cur, len );
+
+    std::uint64_t ends[ 8 ];
+    _mm256_storeu_si256( reinterpret_cast< __m256i* >( ends ),     cur.lo );
+    _mm256_storeu_si256( reinterpret_cast< __m256i* >( ends + 4 ), cur.hi );
+    return( highest_run( ends, len ) );
+}
+
+/**
+ * avx512 - whole leaf in one register.
+ */
+template < int S > __attribute__(( target( "avx512f" ) ))
+inline __m512i shl_avx512( const __m512i v )
+{
+    static_assert( ( S & ( S - 1 ) ) == 0 && S <= 256, "S must be a power of two <= 256" );
+    const auto zero = _mm512_setzero_si512();
+    if constexpr( S >= 64 )
+    {
+        /** lane w gets lane w - Q, concat is [ zero : v ] **/
+        return( _mm512_alignr_epi64( v, zero, 8 - ( S / 64 ) ) );
+    }
+    else
+    {
+        const auto prev = _mm512_alignr_epi64( v, zero, 7 );
+        return( _mm512_or_si512( _mm512_slli_epi64( v, S ),
+                                 _mm512_srli_epi64( prev, 64 - S ) ) );
+    }
+}
+
+template < int K > __attribute__(( target( "avx512f" ) ))
+inline void build_ends_avx512( __m512i e[ 9 ] )
+{
+    if constexpr( K <= 8 )
+    {
+        e[ K ] = _mm512_and_si512( e[ K - 1 ], shl_avx512< ( 1 << ( K - 1 ) ) >( e[ K - 1 ] ) );
+        build_ends_avx512< K + 1 >( e );
+    }
+}
+
+template < int K > __attribute__(( target( "avx512f" ) ))
+inline void grow_run_avx512( const __m512i e[ 9 ], __m512i &cur, std::int32_t &len )
+{
+    if constexpr( K >= 0 )
+    {
+        const auto cand = ( len == 0 ? e[ K ] : 
+                                       _mm512_and_si512( e[ K ], shl_avx512< ( 1 << K ) >( cur ) ) );
+        if( _mm512_test_epi64_mask( cand, cand ) != 0 )
+        {
+            cur  = cand;
+            len += ( 1 << K );
+        }
+        grow_run_avx512< K - 1 >( e, cur, len );
+    }
+}
+
+__attribute__(( target( "avx512f,avx512vpopcntdq" ) ))
+std::uint16_t total_bits_set_avx512( alloc::_512bits *f )
+{
+    const auto v = _mm512_loadu_si512( f );
+    return( static_cast< std::uint16_t >(
+        _mm512_reduce_add_epi64( _mm512_popcnt_epi64( v ) ) ) );
+}
+
+__attribute__(( target( "avx512f" ) ))
+range_t find_longest_contiguous_zeros_avx512( alloc::_512bits *f )
+{
+    const auto ones = _mm512_set1_epi64( -1 );
+    __m512i e[ 9 ];
+    e[ 0 ] = _mm512_xor_si512( _mm512_loadu_si512( f ), ones );
+    if( _mm512_test_epi64_mask( e[ 0 ], e[ 0 ] ) == 0 )
+    {
+        return( std::make_pair( 0, 0 ) );
+    }
+    if( _mm512_cmpeq_epi64_mask( e[ 0 ], ones ) == 0xff )
+    {
+        return( std::make_pair( 512, 0 ) );
+    }
+    build_ends_avx512< 1 >( e );
+
+    __m512i         cur = e[ 0 ];
+    std::int32_t    len = 0;
+    grow_run_avx512< 8 >( e, cur, len );
+
+    std::uint64_t ends[ 8 ];
+    _mm512_storeu_si512( ends, cur );
+    return( highest_run( ends, len ) );
+}
+
+#endif /** end HEAPALLOC_X86 **/
+
+bool supported( const alloc::_512bits::kernel k )
+{
+#if HEAPALLOC_X86
+    __builtin_cpu_init();
+    const bool popcnt_tzcnt = __builtin_cpu_supports( "popcnt" ) &&
+                              __builtin_cpu_supports( "bmi" );
+    switch( k )
+    {
+        case( alloc::_512bits::generic ):
+            return( true );
+        case( alloc::_512bits::scalar ):
+            return( popcnt_tzcnt );
+        case( alloc::_512bits::avx2 ):
+            return( popcnt_tzcnt && __builtin_cpu_supports( "avx2" ) );
+        case( alloc::_512bits::avx512 ):
+            return( popcnt_tzcnt &&
+                    __builtin_cpu_supports( "avx512f" ) &&
+                    __builtin_cpu_supports( "avx512vpopcntdq" ) );
+        default:
+            return( false );
+    }
+#else
+    return( k == alloc::_512bits::generic );
+#endif
+}
+
+dispatch_t make_dispatch( const alloc::_512bits::kernel k )
+{
+    dispatch_t d;
+    d.k = k;
+    switch( k )
+    {
+#if HEAPALLOC_X86
+        case( alloc::_512bits::scalar ):
+            d.total_bits_set    = total_bits_set_scalar;
+            d.longest_zeros     = find_longest_contiguous_zeros_scalar;
+            break;
+        case( alloc::_512bits::avx2 ):
+            d.total_bits_set    = total_bits_set_avx2;
+            d.longest_zeros     = find_longest_contiguous_zeros_avx2;
+            break;
+        case( alloc::_512bits::avx512 ):
+            d.total_bits_set    = total_bits_set_avx512;
+            d.longest_zeros     = find_longest_contiguous_zeros_avx512;
+            break;
+#endif
+        default:
+            d.k = alloc::_512bits::generic;
+            break;
+    }
+    return( d );
+}
+
+const dispatch_t& best_dispatch()
+{
+    static const dispatch_t d = []()
+    {
+        for( int k( alloc::_512bits::n_kernels - 1 ); k > alloc::_512bits::generic; k-- )
+        {
+            const auto kern = static_cast< alloc::_512bits::kernel >( k );
+            if( supported( kern ) )
+            {
+                return( make_dispatch( kern ) );
+            }
+        }
+        return( make_dispatch( alloc::_512bits::generic ) );
+    }();
+    return( d );
+}
+
+} /** end anonymous namespace **/
+
+bool
+alloc::_512bits::kernel_supported( const kernel k )
+{
+    return( supported( k ) );
+}
+
+alloc::_512bits::kernel
+alloc::_512bits::active_kernel()
+{
+    return( best_dispatch().k );
+}
+
+std::uint16_t
+alloc::_512bits::total_bits_set( _512bits *f )
+{
+    return( best_dispatch().total_bits_set( f ) );
+}
+
+std::uint16_t
+alloc::_512bits::total_bits_set( _512bits *f, const kernel k )
+{
+    assert( supported( k ) );
+    return( make_dispatch( k ).total_bits_set( f ) );
+}
+
+range_t
+alloc::_512bits::find_longest_contiguous_zeros( _512bits *f )
+{
+    return( best_dispatch().longest_zeros( f ) );
+}
+
+range_t
+alloc::_512bits::find_longest_contiguous_zeros( _512bits *f, const kernel k )
+{
+    assert( supported( k ) );
+    return( make_dispatch( k ).longest_zeros( f ) );
+}
@@ -0,0 +1,133 @@
+/**
+ * buddyheap.cpp - random mixed size allocations against a shadow map
+ * of the blocks, nothing handed out twice, frees of any sub-range
+ * (not just what was allocated) have to work, and everything has to
+ * merge back into one block at the end.
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <utility>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+using heap_t = alloc::heap< 28, 12, alloc::buddy >;
+
+static_assert( ! heap_t::is_lock_free, "buddy heap is locked" );
+
+static bool run( heap_t *h, const std::uint64_t active )
+{
+    heap_t::initialize( h, active );
+    std::vector< bool > used( heap_t::numBlocks, false );
+    std::vector< std::pair< std::int64_t, std::int64_t > > held;
+    std::mt19937 gen( 11 );
+    for( int iter( 0 ); iter < 200000; iter++ )
+    {
+        if( held.empty() || ( gen() % 5 ) < 3 )
+        {
+            /** mostly small, some past a leaf's worth **/
+            const std::uint32_t n = ( gen() % 8 ) == 0 ? 1 + ( gen() % 2048 ) : 1 + ( gen() % 64 );
+            const std::int64_t base = heap_t::get_n_blocks( n, h );
+            if( base < 0 )
+            {
+                continue;
+            }
+            if( std::uint64_t( base + n ) > active )
+            {
+                std::cerr << "handed out blocks past the active ones\n";
+                return( false );
+            }
+            for( auto b( base ); b < base + std::int64_t( n ); b++ )
+            {
+                if( used[ b ] )
+                {
+                    std::cerr << "block " << b << " handed out twice\n";
+                    return( false );
+                }
+                used[ b ] = true;
+            }
+            held.emplace_back( base, n );
+        }
+        else
+        {
+            const auto i = gen() % held.size();
+            auto range = held[ i ];
+            held[ i ] = held.back();
+            held.pop_back();
+            /** sometimes give back only the front, keep the rest for later **/
+            if( range.second > 1 && ( gen() % 3 ) == 0 )
+            {
+                const auto front = 1 + ( gen() % ( range.second - 1 ) );
+                held.emplace_back( range.first + front, range.second - front );
+                range.second = front;
+            }
+            for( auto b( range.first ); b < range.first + range.second; b++ )
+            {
+                used[ b ] = false;
+            }
+            heap_t::return_n_blocks( range.first, range.second, h );
+        }
+    }
+    std::uint64_t in_use = 0;
+    for( const auto &r : held )
+    {
+        in_use += r.second;
+    }
+    if( heap_t::get_current_free( h ) != active - in_use )
+    {
+        std::cerr << "free count off\n";
+        return( false );
+    }
+    for( const auto &r : held )
+    {
+        heap_t::return_n_blocks( r.first, r.second, h );
+    }
+    /** everything should have merged back into the largest aligned block **/
+    std::uint64_t largest = 1;
+    while( ( largest << 1 ) <= active )
+    {
+        largest <<= 1;
+    }
+    if( heap_t::get_current_free( h ) != active || heap_t::get_blocks_avail( h ) != largest )
+    {
+        std::cerr << "didn't coalesce, largest free " << heap_t::get_blocks_avail( h ) << 
+            " expected " << largest << "\n";
+        return( false );
+    }
+    /** and all of it has to be usable again **/
+    if( heap_t::get_n_blocks( active, h ) != ( active == largest ? 0 : -1 ) )
+    {
+        std::cerr << "whole heap allocation wrong\n";
+        return( false );
+    }
+    return( true );
+}
+
+int main()
+{
+    auto *h = new heap_t();
+    if( ! run( h, heap_t::numBlocks ) || ! run( h, heap_t::numBlocks - 1000 ) || ! run( h, 5000 ) )
+    {
+        delete( h );
+        return( EXIT_FAILURE );
+    }
+    delete( h );
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,135 @@
+/**
+ * freshinit.cpp - initialize writes the empty heap out directly, it
+ * has to come out exactly as it would have leaf by leaf with add(),
+ * for full, partial and single leaf heaps.
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+using heap_t    = alloc::heap< 30, 12 >;
+using lf_heap_t = alloc::heap< 30, 12, alloc::lock_free >;
+
+/** the way initialize used to do it **/
+static void reference_initialize( heap_t *h, const std::uint64_t active_blocks )
+{
+    std::memset( &h->offsetArray, 0x0, sizeof( h->offsetArray ) );
+    h->active_leaves = ( active_blocks + 511 ) / 512;
+    const std::uint16_t tail = active_blocks % 512;
+    if( tail != 0 )
+    {
+        alloc::_512bits::set_range( tail, 512, &h->offsetArray[ h->active_leaves - 1 ] );
+    }
+    h->n = 0;
+    for( std::uint64_t i( 0 ); i < h->active_leaves; i++ )
+    {
+        heap_t::add( i, h );
+    }
+    h->overall_blocks = active_blocks;
+    h->total_blocks   = active_blocks;
+}
+
+static bool same( heap_t *a, heap_t *b, const std::uint64_t active_blocks )
+{
+    if( a->n != b->n || a->active_leaves != b->active_leaves ||
+        a->overall_blocks != b->overall_blocks )
+    {
+        std::cerr << active_blocks << ": counts differ\n";
+        return( false );
+    }
+    for( std::int32_t i( 0 ); i < a->n; i++ )
+    {
+        const auto &x = a->arr[ i ];
+        const auto &y = b->arr[ i ];
+        if( x.blocks_free != y.blocks_free || x.contiguous_free != y.contiguous_free ||
+            x.index != y.index || x.offset_to_contiguous_free != y.offset_to_contiguous_free ||
+            a->pos[ i ] != b->pos[ i ] ||
+            std::memcmp( &a->offsetArray[ i ], &b->offsetArray[ i ], sizeof( alloc::_512bits ) ) != 0 )
+        {
+            std::cerr << active_blocks << ": slot " << i << " differs\n";
+            return( false );
+        }
+    }
+    return( true );
+}
+
+int main()
+{
+    auto *fast      = new heap_t();
+    auto *reference = new heap_t();
+    const std::uint64_t max_blocks = heap_t::numElements * 512;
+    for( const std::uint64_t active : { max_blocks, max_blocks - 100, 
+                                        std::uint64_t( 1 ), std::uint64_t( 513 ),
+                                        std::uint64_t( 64 * 512 ) } )
+    {
+        /** dirty it first, initialize mustn't depend on what was there **/
+        std::memset( (void*)fast, 0xff, sizeof( heap_t ) );
+        heap_t::initialize( fast, active );
+        reference_initialize( reference, active );
+        if( ! same( fast, reference, active ) )
+        {
+            return( EXIT_FAILURE );
+        }
+        /** and it has to behave like a heap straight away **/
+        const auto base = heap_t::get_n_blocks( active < 512 ? active : 512, fast );
+        if( base != 0 )
+        {
+            std::cerr << active << ": first allocation should be block 0\n";
+            return( EXIT_FAILURE );
+        }
+        heap_t::return_n_blocks( base, active < 512 ? active : 512, fast );
+        if( heap_t::get_current_free( fast ) != active )
+        {
+            return( EXIT_FAILURE );
+        }
+    }
+
+    auto *lf = new lf_heap_t();
+    std::memset( (void*)lf, 0xff, sizeof( lf_heap_t ) );
+    lf_heap_t::initialize( lf, 1000 );
+    if( lf_heap_t::get_current_free( lf ) != 1000 || lf->hint[ 0 ] != 512 || lf->hint[ 1 ] != 488 ||
+        lf_heap_t::get_n_blocks( 512, lf ) < 0 || lf_heap_t::get_n_blocks( 488, lf ) < 0 ||
+        lf_heap_t::get_n_blocks( 1, lf ) >= 0 )
+    {
+        std::cerr << "lock-free heap not initialized right\n";
+        return( EXIT_FAILURE );
+    }
+
+    /** largest heap a buffer can have, this is what creating one costs **/
+    using big_heap_t = alloc::heap< 34, 12 >;
+    auto *big = new big_heap_t();
+    const auto start = std::chrono::steady_clock::now();
+    for( auto i( 0 ); i < 100; i++ )
+    {
+        big_heap_t::initialize( big );
+        __asm__ volatile( "" : : "r"( big ) : "memory" );
+    }
+    const auto end = std::chrono::steady_clock::now();
+    std::cout << "initialize: " << 
+        std::chrono::duration< double, std::micro >( end - start ).count() / 100 << "us\n";
+    delete( big );
+
+    delete( fast );
+    delete( reference );
+    delete( lf );
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,192 @@
+/**
+ * heapcompare.cpp - run the same allocation trace through each heap
+ * backend and report latency and how often an allocation failed even
+ * though there were enough free blocks (fragmentation). The default
+ * trace is mixed 4KiB-2MiB requests (log uniform) with the heap kept
+ * around 85% full, pass a trace file to replay your own, one op per
+ * line:
+ *   a <id> <bytes>  - allocate
+ *   f <id>          - free whatever id was given
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+constexpr static int total_pow_two = 30;
+constexpr static int block_pow_two = 12;
+
+struct op_t
+{
+    bool            allocate;
+    std::uint64_t   id;
+    std::uint64_t   bytes;
+};
+
+static std::vector< op_t > generate_trace( const std::size_t n_ops )
+{
+    const std::uint64_t capacity = std::uint64_t( 1 ) << total_pow_two;
+    std::vector< op_t > trace;
+    std::vector< std::pair< std::uint64_t, std::uint64_t > > live;
+    std::uint64_t in_use  = 0;
+    std::uint64_t next_id = 0;
+    std::mt19937_64 gen( 1 );
+    /** 2^12 to 2^21 bytes, log uniform, then jittered within the power **/
+    std::uniform_int_distribution< int > pow_dist( 12, 21 );
+    while( trace.size() < n_ops )
+    {
+        const bool allocate = live.empty() || 
+                              ( in_use < ( capacity / 100 ) * 85 && ( gen() % 8 ) != 0 );
+        if( allocate )
+        {
+            const auto p     = pow_dist( gen );
+            const auto bytes = ( std::uint64_t( 1 ) << p ) - 
+                               ( gen() % ( std::uint64_t( 1 ) << ( p - 1 ) ) );
+            trace.push_back( { true, next_id, bytes } );
+            live.emplace_back( next_id++, bytes );
+            in_use += bytes;
+        }
+        else
+        {
+            const auto i = gen() % live.size();
+            trace.push_back( { false, live[ i ].first, 0 } );
+            in_use -= live[ i ].second;
+            live[ i ] = live.back();
+            live.pop_back();
+        }
+    }
+    return( trace );
+}
+
+static bool read_trace( const char *path, std::vector< op_t > &trace )
+{
+    std::ifstream in( path );
+    if( ! in.is_open() )
+    {
+        return( false );
+    }
+    char            op;
+    std::uint64_t   id;
+    while( in >> op >> id )
+    {
+        std::uint64_t bytes = 0;
+        if( op == 'a' && !( in >> bytes ) )
+        {
+            return( false );
+        }
+        trace.push_back( { op == 'a', id, bytes } );
+    }
+    return( true );
+}
+
+template < class HEAP > static void run( const char *name, const std::vector< op_t > &trace )
+{
+    auto *h = new HEAP();
+    std::unordered_map< std::uint64_t, std::pair< std::int64_t, std::uint32_t > > live;
+    std::vector< double > alloc_ns, free_ns;
+    alloc_ns.reserve( trace.size() );
+    free_ns.reserve( trace.size() );
+    std::size_t failed      = 0;
+    std::size_t frag_failed = 0;
+    for( const auto &op : trace )
+    {
+        if( op.allocate )
+        {
+            const auto n = static_cast< std::uint32_t >( HEAP::get_block_multiple( op.bytes ) );
+            const auto s = std::chrono::steady_clock::now();
+            const auto base = HEAP::get_n_blocks( n, h );
+            const auto e = std::chrono::steady_clock::now();
+            alloc_ns.push_back( std::chrono::duration< double, std::nano >( e - s ).count() );
+            if( base < 0 )
+            {
+                failed++;
+                frag_failed += ( HEAP::get_current_free( h ) >= n );
+                continue;
+            }
+            live[ op.id ] = { base, n };
+        }
+        else
+        {
+            const auto it = live.find( op.id );
+            if( it == live.end() )
+            {
+                /** its allocation failed **/
+                continue;
+            }
+            const auto s = std::chrono::steady_clock::now();
+            HEAP::return_n_blocks( it->second.first, it->second.second, h );
+            const auto e = std::chrono::steady_clock::now();
+            free_ns.push_back( std::chrono::duration< double, std::nano >( e - s ).count() );
+            live.erase( it );
+        }
+    }
+    auto summary = []( std::vector< double > &v, double &mean, double &p99 )
+    {
+        mean = p99 = 0;
+        if( v.empty() )
+        {
+            return;
+        }
+        for( const auto x : v )
+        {
+            mean += x;
+        }
+        mean /= v.size();
+        std::sort( v.begin(), v.end() );
+        p99 = v[ ( v.size() * 99 ) / 100 ];
+    };
+    double am, ap, fm, fp;
+    summary( alloc_ns, am, ap );
+    summary( free_ns,  fm, fp );
+    std::cout << std::setw( 10 ) << name << std::fixed << std::setprecision( 1 ) <<
+        "  alloc mean " << std::setw( 8 ) << am << "ns p99 " << std::setw( 8 ) << ap << "ns" <<
+        "  free mean "  << std::setw( 8 ) << fm << "ns p99 " << std::setw( 8 ) << fp << "ns" <<
+        "  failed " << failed << " (" << frag_failed << " with enough free)\n";
+    delete( h );
+}
+
+int main( int argc, char **argv )
+{
+    std::vector< op_t > trace;
+    if( argc > 1 )
+    {
+        if( ! read_trace( argv[ 1 ], trace ) )
+        {
+            std::cerr << "couldn't read trace " << argv[ 1 ] << "\n";
+            return( EXIT_FAILURE );
+        }
+    }
+    else
+    {
+        trace = generate_trace( 200000 );
+    }
+    std::cout << trace.size() << " ops over 2^" << total_pow_two << "B of 2^" << 
+        block_pow_two << "B blocks\n";
+    run< alloc::heap< total_pow_two, block_pow_two, alloc::locked > >( "locked", trace );
+    run< alloc::heap< total_pow_two, block_pow_two, alloc::lock_free > >( "lock_free", trace );
+    run< alloc::heap< total_pow_two, block_pow_two, alloc::buddy > >( "buddy", trace );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,97 @@
+/**
+ * heapposition.cpp - the leaf -> heap slot map has to track every
+ * swap, and the heap has to stay a heap when frees go straight to
+ * the slot rather than searching for it.
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <utility>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+using heap_t = alloc::heap< 30, 12 >;
+
+static bool consistent( heap_t *h )
+{
+    const alloc::node_index_t n = h->n;
+    for( alloc::node_index_t slot( 0 ); slot < n; slot++ )
+    {
+        if( h->pos[ h->arr[ slot ].index ] != slot )
+        {
+            std::cerr << "pos for leaf " << h->arr[ slot ].index << " is stale\n";
+            return( false );
+        }
+        if( slot > 0 && 
+            h->arr[ heap_t::parent( slot ) ].contiguous_free < h->arr[ slot ].contiguous_free )
+        {
+            std::cerr << "heap order broken at slot " << slot << "\n";
+            return( false );
+        }
+    }
+    return( true );
+}
+
+int main()
+{
+    auto *theheap = new heap_t();
+    if( ! consistent( theheap ) )
+    {
+        return( EXIT_FAILURE );
+    }
+    
+    std::mt19937 gen( 7 );
+    std::vector< std::pair< std::int32_t, std::uint32_t > > held;
+    for( int iter( 0 ); iter < 100000; iter++ )
+    {
+        if( held.empty() || ( gen() % 3 ) != 0 )
+        {
+            const std::uint32_t n = 1 + ( gen() % 128 );
+            const auto base = heap_t::get_n_blocks( n, theheap );
+            if( base >= 0 )
+            {
+                held.emplace_back( base, n );
+            }
+        }
+        else
+        {
+            const auto i = gen() % held.size();
+            heap_t::return_n_blocks( held[ i ].first, held[ i ].second, theheap );
+            held[ i ] = held.back();
+            held.pop_back();
+        }
+        if( ( iter % 1000 ) == 0 && ! consistent( theheap ) )
+        {
+            return( EXIT_FAILURE );
+        }
+    }
+    for( const auto &p : held )
+    {
+        heap_t::return_n_blocks( p.first, p.second, theheap );
+    }
+    if( ! consistent( theheap ) || 
+        heap_t::get_current_free( theheap ) != heap_t::numElements * 512 ||
+        heap_t::get_blocks_avail( theheap ) != 512 )
+    {
+        return( EXIT_FAILURE );
+    }
+    delete( theheap );
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
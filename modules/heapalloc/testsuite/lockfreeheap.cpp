@@ -0,0 +1,139 @@
+/**
+ * lockfreeheap.cpp - hammer the lock-free heap from several threads
+ * and make sure no block is ever handed out twice and that everything
+ * comes back.
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <random>
+#include <utility>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+using heap_t = alloc::heap< 24, 12, alloc::lock_free >;
+
+static_assert( heap_t::is_lock_free, "expected lock free heap" );
+
+/** one owner per block, 0 == free **/
+static std::atomic< std::uint32_t > owner[ heap_t::numElements * heap_t::blocksize_bits ];
+static std::atomic< bool >          failed = { false };
+
+static void worker( const std::uint32_t id, heap_t *h )
+{
+    std::mt19937 gen( id );
+    std::uniform_int_distribution< std::uint32_t > size_dist( 1, 64 );
+    std::vector< std::pair< std::int32_t, std::uint32_t > > held;
+    for( auto iter( 0 ); iter < 20000 && ! failed; iter++ )
+    {
+        if( held.size() < 16 && ( gen() & 1 ) )
+        {
+            const auto n        = size_dist( gen );
+            const auto base     = heap_t::get_n_blocks( n, h );
+            if( base < 0 )
+            {
+                continue;
+            }
+            for( auto b( base ); b < base + static_cast< std::int32_t >( n ); b++ )
+            {
+                std::uint32_t expected = 0;
+                if( ! owner[ b ].compare_exchange_strong( expected, id ) )
+                {
+                    std::cerr << "block " << b << " handed to " << id << 
+                        " but owned by " << expected << "\n";
+                    failed = true;
+                }
+            }
+            held.emplace_back( base, n );
+        }
+        else if( ! held.empty() )
+        {
+            const auto p = held.back();
+            held.pop_back();
+            for( auto b( p.first ); b < p.first + static_cast< std::int32_t >( p.second ); b++ )
+            {
+                owner[ b ].store( 0 );
+            }
+            heap_t::return_n_blocks( p.first, p.second, h );
+        }
+    }
+    for( const auto &p : held )
+    {
+        for( auto b( p.first ); b < p.first + static_cast< std::int32_t >( p.second ); b++ )
+        {
+            owner[ b ].store( 0 );
+        }
+        heap_t::return_n_blocks( p.first, p.second, h );
+    }
+}
+
+int main()
+{
+    auto *theheap = new heap_t();
+    const auto total = heap_t::get_current_free( theheap );
+    if( total != heap_t::numElements * heap_t::blocksize_bits )
+    {
+        std::cerr << "wrong initial size\n";
+        return( EXIT_FAILURE );
+    }
+    
+    /** fill it up single threaded, every leaf should come back whole **/
+    for( std::uint64_t i( 0 ); i < heap_t::numElements; i++ )
+    {
+        if( heap_t::get_n_blocks( 512, theheap ) < 0 )
+        {
+            std::cerr << "failed to get full leaf " << i << "\n";
+            return( EXIT_FAILURE );
+        }
+    }
+    if( heap_t::get_n_blocks( 1, theheap ) != -1 || heap_t::get_current_free( theheap ) != 0 )
+    {
+        std::cerr << "heap should be full\n";
+        return( EXIT_FAILURE );
+    }
+    for( std::uint64_t i( 0 ); i < heap_t::numElements; i++ )
+    {
+        heap_t::return_n_blocks( i * 512, 512, theheap );
+    }
+
+    std::vector< std::thread > threads;
+    for( std::uint32_t i( 1 ); i <= 4; i++ )
+    {
+        threads.emplace_back( worker, i, theheap );
+    }
+    for( auto &t : threads )
+    {
+        t.join();
+    }
+    if( failed )
+    {
+        return( EXIT_FAILURE );
+    }
+    if( heap_t::get_current_free( theheap ) != total ||
+        heap_t::get_blocks_avail( theheap ) != 512 )
+    {
+        std::cerr << "blocks leaked, have " << heap_t::get_current_free( theheap ) << 
+            " expected " << total << "\n";
+        return( EXIT_FAILURE );
+    }
+    delete( theheap );
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
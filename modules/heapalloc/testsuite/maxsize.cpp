@@ -0,0 +1,78 @@
+/**
+ * maxsize.cpp - heaps at the largest buffer the ipc buffer accepts
+ * (2^37 bytes of 4KiB blocks, 2^16 leaves), enough allocations to fill
+ * every leaf and push leaves all the way down the tree, then give it
+ * all back.
+ * @author: Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+template < class HEAP > static bool fill_and_drain( const char *name )
+{
+    auto *h = new HEAP();
+    const auto total = HEAP::get_total_blocks( h );
+    if( total != ( std::size_t( 1 ) << ( 37 - 12 ) ) )
+    {
+        std::cerr << name << ": " << total << " blocks\n";
+        return( false );
+    }
+    /** 300 doesn't divide 512, so runs straddle leaves and leave tails **/
+    const std::uint32_t n = 300;
+    std::vector< std::int64_t > starts;
+    for( ;; )
+    {
+        const auto start = HEAP::get_n_blocks( n, h );
+        if( start < 0 )
+        {
+            break;
+        }
+        starts.push_back( start );
+    }
+    /** at least one per leaf, heaps that span leaves get more **/
+    if( starts.size() < total / HEAP::blocksize_bits || starts.size() > total / n )
+    {
+        std::cerr << name << ": got " << starts.size() << " runs\n";
+        return( false );
+    }
+    for( const auto start : starts )
+    {
+        HEAP::return_n_blocks( start, n, h );
+    }
+    const bool all_back = ( HEAP::get_current_free( h ) == total );
+    if( ! all_back )
+    {
+        std::cerr << name << ": " << HEAP::get_current_free( h ) << " free after returning everything\n";
+    }
+    delete( h );
+    return( all_back );
+}
+
+int main()
+{
+    if( ! fill_and_drain< alloc::heap< 37, 12 > >( "locked" ) ||
+        ! fill_and_drain< alloc::heap< 37, 12, alloc::lock_free > >( "lock_free" ) ||
+        ! fill_and_drain< alloc::heap< 37, 12, alloc::buddy > >( "buddy" ) )
+    {
+        return( EXIT_FAILURE );
+    }
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,151 @@
+/**
+ * simdkernels.cpp - every _512bits kernel the CPU supports must give
+ * exactly the same answers as the generic version.
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "_512bits.hpp"
+
+static const char *names[ alloc::_512bits::n_kernels ] = { "generic", "scalar", "avx2", "avx512" };
+
+static bool check( alloc::_512bits &bits, const char *pattern )
+{
+    const auto expected_count   = alloc::_512bits::total_bits_set_generic( &bits );
+    const auto expected_run     = alloc::_512bits::find_longest_contiguous_zeros_generic( &bits );
+    for( int k( alloc::_512bits::generic ); k < alloc::_512bits::n_kernels; k++ )
+    {
+        const auto kern = static_cast< alloc::_512bits::kernel >( k );
+        if( ! alloc::_512bits::kernel_supported( kern ) )
+        {
+            continue;
+        }
+        const auto count    = alloc::_512bits::total_bits_set( &bits, kern );
+        const auto run      = alloc::_512bits::find_longest_contiguous_zeros( &bits, kern );
+        if( count != expected_count || run != expected_run )
+        {
+            std::cerr << names[ k ] << " kernel mismatch on " << pattern << 
+                ": count " << count << " vs " << expected_count << 
+                ", run (" << run.first << ", " << run.second << ") vs (" << 
+                expected_run.first << ", " << expected_run.second << ")\n";
+            return( false );
+        }
+    }
+    return( true );
+}
+
+int main()
+{
+    for( int k( alloc::_512bits::generic ); k < alloc::_512bits::n_kernels; k++ )
+    {
+        std::cout << names[ k ] << ": " << 
+            ( alloc::_512bits::kernel_supported( static_cast< alloc::_512bits::kernel >( k ) ) ? 
+                "supported" : "not supported" ) << "\n";
+    }
+    std::cout << "active: " << names[ alloc::_512bits::active_kernel() ] << "\n";
+
+    alloc::_512bits bits;
+    
+    /** the easy ones, all free and all taken **/
+    std::memset( &bits, 0x0, sizeof( bits ) );
+    if( ! check( bits, "all zeros" ) )
+    {
+        return( EXIT_FAILURE );
+    }
+    std::memset( &bits, 0xff, sizeof( bits ) );
+    if( ! check( bits, "all ones" ) )
+    {
+        return( EXIT_FAILURE );
+    }
+
+    /** single bit set and single bit free at every position **/
+    for( std::uint16_t i( 0 ); i < 512; i++ )
+    {
+        std::memset( &bits, 0x0, sizeof( bits ) );
+        alloc::_512bits::set_bit( i, &bits );
+        if( ! check( bits, "single one" ) )
+        {
+            return( EXIT_FAILURE );
+        }
+        std::memset( &bits, 0xff, sizeof( bits ) );
+        alloc::_512bits::unset_bit( i, &bits );
+        if( ! check( bits, "single zero" ) )
+        {
+            return( EXIT_FAILURE );
+        }
+    }
+    
+    /** two equal length runs, the higher one should win **/
+    std::memset( &bits, 0xff, sizeof( bits ) );
+    for( std::uint16_t i( 10 ); i < 30; i++ )
+    {
+        alloc::_512bits::unset_bit( i, &bits );
+        alloc::_512bits::unset_bit( i + 300, &bits );
+    }
+    if( ! check( bits, "tie" ) )
+    {
+        return( EXIT_FAILURE );
+    }
+
+    /** 
+     * random bitmaps, both uniformly random bits at several densities
+     * and runs of random length, which is what a leaf actually looks like.
+     */
+    std::mt19937_64 gen( 42 );
+    for( int iter( 0 ); iter < 200000; iter++ )
+    {
+        std::memset( &bits, 0x0, sizeof( bits ) );
+        if( iter & 1 )
+        {
+            const auto density = gen() % 64;
+            for( std::uint16_t i( 0 ); i < 512; i++ )
+            {
+                if( ( gen() % 64 ) < density )
+                {
+                    alloc::_512bits::set_bit( i, &bits );
+                }
+            }
+        }
+        else
+        {
+            std::uint16_t pos = gen() % 64;
+            bool set = gen() & 1;
+            while( pos < 512 )
+            {
+                const std::uint16_t len = 1 + ( gen() % 200 );
+                for( std::uint16_t i( pos ); i < pos + len && i < 512; i++ )
+                {
+                    if( set )
+                    {
+                        alloc::_512bits::set_bit( i, &bits );
+                    }
+                }
+                pos += len;
+                set = ! set;
+            }
+        }
+        if( ! check( bits, "random" ) )
+        {
+            return( EXIT_FAILURE );
+        }
+    }
+    
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,144 @@
+/**
+ * spanblocks.cpp - allocations larger than a single 512 block leaf,
+ * for both the locked and the lock-free heap.
+ * @author: Jonathan Beard
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdint>
+#include <iostream>
+#include <cstdlib>
+
+#define TESTHEAP 1
+#include "allocheap.hpp"
+
+template < class HEAP > static bool run_test( const char *name )
+{
+    auto *h = new HEAP();
+    const auto total = HEAP::get_current_free( h );
+    
+    /** take a few blocks out of leaf 0 so the first span has to skip it **/
+    const auto small = HEAP::get_n_blocks( 10, h );
+    if( small < 0 )
+    {
+        std::cerr << name << ": small allocation failed\n";
+        return( false );
+    }
+
+    /** 16MiB worth of 4KiB blocks, 8 leaves, then 8 leaves + a partial one **/
+    const std::uint32_t span_a_blocks = 8 * 512;
+    const std::uint32_t span_b_blocks = ( 8 * 512 ) + 100;
+    const auto a = HEAP::get_n_blocks( span_a_blocks, h );
+    const auto b = HEAP::get_n_blocks( span_b_blocks, h );
+    if( a < 0 || b < 0 )
+    {
+        std::cerr << name << ": span allocation failed\n";
+        return( false );
+    }
+    if( ( a % 512 ) != 0 || ( b % 512 ) != 0 )
+    {
+        std::cerr << name << ": spans should start at a leaf boundary\n";
+        return( false );
+    }
+    const auto small_leaf = small / 512;
+    if( small_leaf >= a / 512 && 
+        small_leaf < ( a + static_cast< std::int32_t >( span_a_blocks ) + 511 ) / 512 )
+    {
+        std::cerr << name << ": span a overlaps the partially used leaf\n";
+        return( false );
+    }
+    if( ( a < b && a + static_cast< std::int32_t >( span_a_blocks ) > b ) ||
+        ( b < a && b + static_cast< std::int32_t >( span_b_blocks ) > a ) )
+    {
+        std::cerr << name << ": spans overlap\n";
+        return( false );
+    }
+    if( HEAP::get_current_free( h ) != total - 10 - span_a_blocks - span_b_blocks )
+    {
+        std::cerr << name << ": wrong free count after spans\n";
+        return( false );
+    }
+    
+    /** the tail of span b's last leaf should still be usable **/
+    const auto tail = HEAP::get_n_blocks( 400, h );
+    if( tail < 0 )
+    {
+        std::cerr << name << ": failed to allocate after spans\n";
+        return( false );
+    }
+
+    /** more than the whole heap can never work **/
+    if( HEAP::get_n_blocks( HEAP::numElements * 512 + 1, h ) != -1 )
+    {
+        std::cerr << name << ": impossible span succeeded\n";
+        return( false );
+    }
+    
+    HEAP::return_n_blocks( b, span_b_blocks, h );
+    HEAP::return_n_blocks( a, span_a_blocks, h );
+    HEAP::return_n_blocks( tail, 400, h );
+    HEAP::return_n_blocks( small, 10, h );
+    if( HEAP::get_current_free( h ) != total || HEAP::get_blocks_avail( h ) != 512 )
+    {
+        std::cerr << name << ": blocks not all returned\n";
+        return( false );
+    }
+
+    /** everything free, the whole heap as one span **/
+    const auto all = HEAP::get_n_blocks( HEAP::numElements * 512, h );
+    if( all != 0 || HEAP::get_current_free( h ) != 0 )
+    {
+        std::cerr << name << ": whole heap span failed\n";
+        return( false );
+    }
+    HEAP::return_n_blocks( all, HEAP::numElements * 512, h );
+    if( HEAP::get_current_free( h ) != total )
+    {
+        std::cerr << name << ": whole heap span not returned\n";
+        return( false );
+    }
+
+    /** only three and a bit leaves backed, nothing past that is handed out **/
+    const std::uint64_t active = ( 3 * 512 ) + 100;
+    HEAP::initialize( h, active );
+    if( HEAP::get_current_free( h ) != active || HEAP::get_total_blocks( h ) != active )
+    {
+        std::cerr << name << ": partial heap has the wrong size\n";
+        return( false );
+    }
+    if( HEAP::get_n_blocks( active + 1, h ) >= 0 )
+    {
+        std::cerr << name << ": span past the active blocks\n";
+        return( false );
+    }
+    const auto front = HEAP::get_n_blocks( 3 * 512, h );
+    const auto last  = HEAP::get_n_blocks( 100, h );
+    if( front != 0 || last != 3 * 512 || HEAP::get_n_blocks( 1, h ) >= 0 )
+    {
+        std::cerr << name << ": partial heap handed out the wrong blocks\n";
+        return( false );
+    }
+    delete( h );
+    return( true );
+}
+
+int main()
+{
+    if( ! run_test< alloc::heap< 30, 12, alloc::locked > >( "locked" ) ||
+        ! run_test< alloc::heap< 30, 12, alloc::lock_free > >( "lock_free" ) )
+    {
+        return( EXIT_FAILURE );
+    }
+    std::cout << "SUCCESS\n";
+    return( EXIT_SUCCESS );
+}
@@ -25,8 +25,13 @@
 #include <sstream>
 #include <utility>
 #include <type_traits>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 #include <typeinfo>
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "sem.hpp"
 #include <buffer>
@@ -34,6 +39,8 @@
 #include <errno.h>
 #include "allocation_metadata.hpp"
 #include "allocationexception.hpp"
+#include "slab.hpp"
+#include "extent.hpp"
 
 ipc::global_err_t ipc::buffer::gb_err;
 
@@ -76,8 +83,14 @@ ipc::buffer::buffer() : buffer_base()
 }
 
 ipc::buffer*
-ipc::buffer::initialize( const shm_key_t &shm_handle )
+ipc::buffer::initialize( const shm_key_t           &shm_handle,
+                         const ipc::buffer_config  &config,
+                         ipc::prefault_report      *report )
 {
+    if( ! config.valid() )
+    {
+        return( nullptr );
+    }
     if( ! shm::key_copy( ipc::buffer::gb_err.shm_handle, shm_handle ) )
     {
         ipc::buffer::gb_err.err_msg << "Failed to copy shared memory handle to error stream, exiting!" ;
@@ -85,7 +98,7 @@ ipc::buffer::initialize( const shm_key_t &shm_handle )
     }
 
     /** constants **/
-    const auto buffer_size_nbytes   = 1 << ipc::buffer_size_pow_two;
+    const auto buffer_size_nbytes   = std::size_t( 1 ) << config.buffer_size_pow_two;
     const auto meta_size_bytes      = sizeof( ipc::buffer_base );
     /** 
      * because of the way the structures are laid out, this should 
@@ -108,6 +121,16 @@ ipc::buffer::initialize( const shm_key_t &shm_handle )
             __asm__ volatile( "nop" : : : );
         }
         ipc::buffer::gb_err.buffer = output;
+        ipc::buffer::advise_pages( &output->data, output->databuffer_size, output->pages );
+        ipc::translate_helper::register_buffer( &output->data,
+                                                output->databuffer_size,
+                                                ipc::buffer::map_extent,
+                                                output );
+        ipc::buffer::prefault( &output->data, 
+                               output->databuffer_size, 
+                               config.prefault,
+                               config.prefault_threads,
+                               report );
         return( output );
     }
     
@@ -192,15 +215,47 @@ ipc::buffer::initialize( const shm_key_t &shm_handle )
 
     out_buffer->allocated_size      = size_we_need;
     out_buffer->databuffer_size     = buffer_size_nbytes;
+    out_buffer->buffer_size_pow_two = config.buffer_size_pow_two;
+    out_buffer->block_size_pow_two  = config.block_size_pow_two;
+    out_buffer->extent_limit        = 1 + config.growth_extents;
+    out_buffer->pages               = config.pages;
+    out_buffer->trim_info.idle_ns.store( std::int64_t( config.trim_idle_ms ) * 1000000, 
+                                    std::memory_order_relaxed );
+    /** before the heap init below touches anything **/
+    ipc::buffer::advise_pages( &out_buffer->data, buffer_size_nbytes, config.pages );
+    /** only turn on as much of the heap as we have blocks for **/
+    ipc::buffer::heap_t::initialize( &out_buffer->heap, 
+                                     buffer_size_nbytes >> config.block_size_pow_two );
     
     ipc::sem::close( sem_alloc );
     ipc::sem::close( sem_index );
 
+    ipc::translate_helper::register_buffer( &out_buffer->data,
+                                            out_buffer->databuffer_size,
+                                            ipc::buffer::map_extent,
+                                            out_buffer );
     out_buffer->cookie.store( ipc::buffer_base::cookie_in_use, 
                               std::memory_order_seq_cst);
+    /** after the cookie so attaching processes aren't held up by it **/
+    ipc::buffer::prefault( &out_buffer->data, 
+                           buffer_size_nbytes, 
+                           config.prefault,
+                           config.prefault_threads,
+                           report );
     return( out_buffer );
 }
 
+ipc::buffer_config
+ipc::buffer::get_config( const ipc::buffer *b )
+{
+    ipc::buffer_config config;
+    config.buffer_size_pow_two  = b->buffer_size_pow_two;
+    config.block_size_pow_two   = b->block_size_pow_two;
+    config.pages                = b->pages;
+    config.trim_idle_ms         = std::uint32_t( 
+        b->trim_info.idle_ns.load( std::memory_order_relaxed ) / 1000000 );
+    return( config );
+}
 
 void 
 ipc::buffer::gen_key( shm_key_t &key, const int proj_id )
@@ -257,6 +312,24 @@ ipc::buffer::destruct( ipc::buffer *b,
     }
     if( unmap )
     {
+        /** extents first, we can only find them through the buffer **/
+        const auto extent_count = b->extent_count.load( std::memory_order_acquire );
+        for( std::uint8_t extent( 1 ); extent < extent_count; extent++ )
+        {
+            /** have to map it to unlink it if we never did **/
+            void *extent_data = 
+                ipc::translate_helper::get_extent( &b->data, extent, unlink );
+            if( extent_data != nullptr )
+            {
+                void *header = ipc::extent_header::get_header( extent_data );
+                shm::close( b->extent_keys[ extent ],
+                            &header,
+                            ipc::extent_header::header_bytes + b->databuffer_size,
+                            false,
+                            unlink );
+            }
+        }
+        ipc::translate_helper::unregister_buffer( &b->data );
         shm::close( shm_handle,
                     (void**)&b,
                     b->allocated_size,
@@ -272,9 +345,19 @@ ipc::buffer::add_channel( ipc::thread_local_data    *data,
                           const ipc::channel_type   type,
                           const ipc::direction_t    dir,
                           const std::size_t         additional_bytes,
-                          ipc::buffer::shm_seg::init_func_t  f )
+                          ipc::buffer::shm_seg::init_func_t  f,
+                          const std::int32_t        numa_node,
+                          const std::size_t         ring_entries )
 {
     assert( data != nullptr );
+    /** ring_entries is in bytes for data channels **/
+    if( ring_entries != 0 && 
+        ! ( type == ipc::spsc_data ? 
+                ipc::buffer::spsc_data::valid_ring_bytes( ring_entries ) :
+                ipc::ch_entries_spsc::valid_depth( ring_entries ) ) )
+    {
+        return( ipc::channel_err );
+    }
     const auto size_to_allocate( sizeof( ipc::channel_index_t ) );
     
     const auto channel_info_multiple  = 
@@ -309,12 +392,29 @@ ipc::buffer::add_channel( ipc::thread_local_data    *data,
     
     if( channel_start < ipc::valid_offset )
     {
+        /** no arena (the channel still works) if every arena slot is taken **/
         const auto additional_byte_multiple = 
-                ipc::buffer::heap_t::get_block_multiple( additional_bytes );
+            ( type == ipc::spsc_record && ! data->buffer->arenas.has_room() ? 0 :
+                ipc::buffer::heap_t::get_block_multiple( additional_bytes ) );
+        /** rings deeper than spsc_q go right behind the channel **/
+        const std::size_t ring_depth = 
+            ( ring_entries == 0 ? ipc::ch_entries_spsc::n_entries : ring_entries );
+        const std::size_t data_ring_bytes = 
+            ( ring_entries == 0 ? ipc::buffer::spsc_data::default_ring_bytes : ring_entries );
+        std::size_t ring_multiple = 0;
+        if( type == ipc::spsc_record && ring_depth > ipc::ch_entries_spsc::n_entries )
+        {
+            ring_multiple = 
+                ipc::buffer::heap_t::get_block_multiple( ring_depth * sizeof( ipc::ptr_offset_t ) );
+        }
+        else if( type == ipc::spsc_data )
+        {
+            ring_multiple = ipc::buffer::heap_t::get_block_multiple( data_ring_bytes );
+        }
         // Create new node -- will have to acquire allocation semaphore
         // BEWARE - we already grabbed index semaphore, they're now nested
         std::size_t blocks_to_allocate = 
-            channel_info_multiple + meta_multiple + additional_byte_multiple;
+            channel_info_multiple + meta_multiple + ring_multiple + additional_byte_multiple;
         
         void *mem_for_new_channel = 
             ipc::buffer::global_buffer_allocate(  data, 
@@ -336,11 +436,14 @@ ipc::buffer::add_channel( ipc::thread_local_data    *data,
         /** need to calculate channel start, don't change pointer yet, we need that **/
         channel_start = meta_offset + meta_multiple;
 
+        /** before anything is written so it faults in on the right node **/
+        ipc::buffer::bind_blocks( data, meta_offset, blocks_to_allocate, numa_node );
+
         //make an actual meta-data structure
         new (mem_for_new_channel) ipc::allocate_metadata( 
             channel_start           
             /** help the allocator find the base and de-allocate this block **/,
-            channel_info_multiple + additional_byte_multiple  
+            channel_info_multiple + ring_multiple + additional_byte_multiple  
             /** count of blocks allocated, not including metadata **/
         );
         
@@ -359,6 +462,7 @@ ipc::buffer::add_channel( ipc::thread_local_data    *data,
          */
         channel = &(**node_to_add);
         channel->meta.type = type;
+        channel->meta.numa_node.store( numa_node, std::memory_order_relaxed );
         switch( channel->meta.type )
         {
             case( ipc::mpmc_record ):
@@ -388,7 +492,28 @@ ipc::buffer::add_channel( ipc::thread_local_data    *data,
             break;
             case( ipc::spsc_record ):
             {
+                channel->meta.ring_mask = std::uint32_t( ring_depth - 1 );
+                if( ring_multiple > 0 )
+                {
+                    channel->meta.ring_base = channel_start + channel_info_multiple;
+                }
                 ipc::buffer::spsc_lock_free::init( channel );
+                if( additional_byte_multiple > 0 )
+                {
+                    /** record arena sits right behind the channel (and ring) **/
+                    channel->arena.base  = channel_start + channel_info_multiple + ring_multiple;
+                    channel->arena.bytes = 
+                        additional_byte_multiple << ipc::block_size_power_two;
+                    data->buffer->arenas.add( channel->arena.base, additional_byte_multiple );
+                }
+            }
+            break;
+            case( ipc::spsc_data ):
+            {
+                /** byte ring right behind the channel, spsc_q isn't used **/
+                channel->meta.ring_mask = std::uint32_t( data_ring_bytes - 1 );
+                channel->meta.ring_base = channel_start + channel_info_multiple;
+                ipc::buffer::spsc_data::init( channel );
             }
             break;
             case( ipc::shared ):
@@ -423,6 +548,26 @@ ipc::buffer::add_channel( ipc::thread_local_data    *data,
     
 
     
+    }
+    else if( numa_node != ipc::any_numa_node )
+    {
+        /** already there, place it if nobody has yet, moves what's faulted in **/
+        auto expected = ipc::any_numa_node;
+        if( channel->meta.numa_node.compare_exchange_strong( expected, numa_node ) )
+        {
+            const std::size_t ring_bytes = 
+                ( channel->meta.type == ipc::spsc_data ? 
+                    ipc::buffer::spsc_data::depth( channel ) :
+                    ipc::buffer::spsc_lock_free::depth( channel ) * sizeof( ipc::ptr_offset_t ) );
+            const std::size_t ring_multiple = 
+                ( channel->meta.ring_base == ipc::invalid_ptr_offset ? 0 :
+                    ipc::buffer::heap_t::get_block_multiple( ring_bytes ) );
+            ipc::buffer::bind_blocks( data, 
+                                      channel_start - meta_multiple, 
+                                      meta_multiple + channel_info_multiple + ring_multiple +
+                                        ( channel->arena.bytes >> ipc::block_size_power_two ),
+                                      numa_node );
+        }
     }
     /**
      * else, find_channel_buffer_offset function has set channel ptr to something valid
@@ -476,10 +621,22 @@ POST:
     
     if( channel != nullptr /** only case if we couldn't allocate mem for channel **/ )
     {
+        ipc::local_allocation_info info( dir );
+        info.channel = channel;
+        if( channel->arena.base != ipc::invalid_ptr_offset && dir == ipc::producer )
+        {
+            info.arena      = &channel->arena;
+            info.arena_base = (ipc::byte_t*)
+                ipc::buffer::translate_block( &data->buffer->data, channel->arena.base );
+        }
+        if( channel->meta.type == ipc::spsc_record && dir == ipc::producer )
+        {
+            info.recycle = &channel->recycle;
+        }
         /** insert zero count allocation struct into local calling TLS **/
         data->channel_local_allocation.insert( 
             std::make_pair( 
-                channel_id, ipc::local_allocation_info( dir ) 
+                channel_id, info 
             ) 
         ); 
         /** insert channel structure into calling TLS **/
@@ -491,9 +648,36 @@ POST:
 ipc::channel_id_t
 ipc::buffer::add_spsc_lf_record_channel(   ipc::thread_local_data   *data, 
                                            const channel_id_t       channel_id,
-                                           ipc::direction_t         dir )
+                                           ipc::direction_t         dir,
+                                           const std::size_t        arena_bytes,
+                                           const std::int32_t       numa_node,
+                                           const std::size_t        ring_entries )
+{
+    return( ipc::buffer::add_channel( data, 
+                                      channel_id, 
+                                      ipc::spsc_record, 
+                                      dir, 
+                                      arena_bytes, 
+                                      nullptr, 
+                                      numa_node,
+                                      ring_entries ) );
+}
+
+ipc::channel_id_t
+ipc::buffer::add_spsc_data_channel(   ipc::thread_local_data   *data, 
+                                      const channel_id_t       channel_id,
+                                      ipc::direction_t         dir,
+                                      const std::size_t        ring_bytes,
+                                      const std::int32_t       numa_node )
 {
-    return( ipc::buffer::add_channel( data, channel_id, ipc::spsc_record, dir ) );
+    return( ipc::buffer::add_channel( data, 
+                                      channel_id, 
+                                      ipc::spsc_data, 
+                                      dir, 
+                                      0, 
+                                      nullptr, 
+                                      numa_node,
+                                      ring_bytes ) );
 }
 
 ipc::channel_id_t
@@ -532,6 +716,19 @@ ipc::buffer::open_shared_segment( ipc::thread_local_data *tls_data,
 std::size_t
 ipc::buffer::get_record_size( ipc::thread_local_data *data, void *ptr )
 {
+    if( ipc::inline_header::has_header( ptr ) )
+    {
+        if( ipc::buffer::is_arena_record( data, ptr ) )
+        {
+            return( ipc::spsc_arena::get_record_size( ptr ) );
+        }
+        if( ipc::inline_header::get_kind( ptr ) == ipc::kind_slab )
+        {
+            return( ipc::slab::get_header( ptr )->record_size );
+        }
+        return( ( ipc::inline_header::get_header( ptr )->block_count << 
+                    ipc::block_size_power_two ) - ipc::inline_header::header_size );
+    }
     /** get number of blocks for the metadata **/
     auto data_block_offset  = calculate_block_offset( &data->buffer->data, ptr );
     
@@ -619,6 +816,12 @@ ipc::buffer::channel_has_data( ipc::thread_local_data *data, const channel_id_t
             size = ipc::buffer::spsc_lock_free::min_consumer_size( channel_info );
         }
         break;
+        case( ipc::spsc_data ):
+        {
+            /** bytes, not messages, filler included **/
+            size = ipc::buffer::spsc_data::size( channel_info );
+        }
+        break;
         default:
             assert( false );
 
@@ -730,6 +933,12 @@ ipc::buffer::remove_channel( ipc::thread_local_data *data,
         auto *channel_index_struct = (ipc::channel_index_t*)
                                                 translate_block( &data->buffer->data,
                                                                  channel_offset );
+        /** nothing in the arena is an arena record once it's freed **/
+        const auto arena_base = (**channel_index_struct).arena.base;
+        if( arena_base != ipc::invalid_ptr_offset )
+        {
+            data->buffer->arenas.remove( arena_base );
+        }
         /** finally, free channel entry itself **/
         ipc::buffer::free_record( data, channel_index_struct );
     }
@@ -760,8 +969,290 @@ ipc::buffer::free_channel_memory( ipc::thread_local_data *data, ipc::local_alloc
                                 info.local_allocation,
                                 info.blocks_available ); 
         }
+        if( info.spare_blocks > 0 )
+        {
+            ipc::buffer::_free( data, 
+                                info.spare_allocation,
+                                info.spare_blocks ); 
+        }
         info.blocks_available = 0;
         info.local_allocation = 0;
+        info.spare_blocks     = 0;
+        info.spare_allocation = ipc::invalid_ptr_offset;
+        for( auto &run : info.parked )
+        {
+            ipc::buffer::free_parked_run( data, run );
+        }
+}
+
+void
+ipc::buffer::free_parked_run( ipc::thread_local_data *data, ipc::parked_run &run )
+{
+    if( ! run.valid )
+    {
+        return;
+    }
+    for( const auto &cursor : run.slab )
+    {
+        if( cursor.block != ipc::invalid_ptr_offset )
+        {
+            auto *header = (ipc::slab_header*) 
+                ipc::buffer::translate_block( &data->buffer->data, cursor.block );
+            ipc::buffer::slab_release( data, header, true );
+        }
+    }
+    if( run.blocks_available > 0 )
+    {
+        ipc::buffer::_free( data, run.local_allocation, run.blocks_available );
+    }
+    if( run.spare_blocks > 0 )
+    {
+        ipc::buffer::_free( data, run.spare_allocation, run.spare_blocks );
+    }
+    run = ipc::parked_run();
+}
+
+void
+ipc::buffer::switch_run_node( ipc::thread_local_data     *data,
+                              ipc::local_allocation_info &info,
+                              const std::int32_t         node )
+{
+    ipc::parked_run current;
+    current.node                = info.run_node;
+    current.local_allocation    = info.local_allocation;
+    current.blocks_available    = info.blocks_available;
+    current.spare_allocation    = info.spare_allocation;
+    current.spare_blocks        = info.spare_blocks;
+    current.valid               = ( info.blocks_available > 0 || info.spare_blocks > 0 );
+    for( std::size_t i( 0 ); i < ipc::slab::n_classes; i++ )
+    {
+        current.slab[ i ] = info.slab[ i ];
+        current.valid    |= ( info.slab[ i ].block != ipc::invalid_ptr_offset );
+    }
+    /** pull out what's parked for node, the rest stay oldest first **/
+    ipc::parked_run incoming;
+    std::size_t     n = 0;
+    for( auto &run : info.parked )
+    {
+        if( ! run.valid )
+        {
+            continue;
+        }
+        if( run.node == node && ! incoming.valid )
+        {
+            incoming = run;
+        }
+        else
+        {
+            info.parked[ n++ ] = run;
+        }
+    }
+    for( auto i( n ); i < ipc::local_allocation_info::max_parked_runs; i++ )
+    {
+        info.parked[ i ] = ipc::parked_run();
+    }
+    if( current.valid )
+    {
+        if( n == ipc::local_allocation_info::max_parked_runs )
+        {
+            ipc::buffer::free_parked_run( data, info.parked[ 0 ] );
+            for( std::size_t i( 1 ); i < n; i++ )
+            {
+                info.parked[ i - 1 ] = info.parked[ i ];
+            }
+            n--;
+        }
+        info.parked[ n ] = current;
+    }
+    info.local_allocation   = incoming.local_allocation;
+    info.blocks_available   = incoming.blocks_available;
+    info.spare_allocation   = incoming.spare_allocation;
+    info.spare_blocks       = incoming.spare_blocks;
+    for( std::size_t i( 0 ); i < ipc::slab::n_classes; i++ )
+    {
+        info.slab[ i ] = incoming.slab[ i ];
+    }
+    info.run_node = node;
+}
+
+bool
+ipc::buffer::refill_local_allocation( ipc::thread_local_data     *data,
+                                      ipc::local_allocation_info &info,
+                                      const std::size_t          blocks )
+{
+    /** the tail kept from last time might do **/
+    if( info.spare_blocks >= blocks )
+    {
+        std::swap( info.local_allocation, info.spare_allocation );
+        std::swap( info.blocks_available, info.spare_blocks );
+        return( true );
+    }
+
+    /** else allocate from global buffer, as much as the policy says **/
+    const auto request = info.refill.next( blocks );
+    std::size_t global_blocks_allocated = request;
+    auto *ret_ptr = ipc::buffer::global_buffer_allocate( data, 
+                                                         global_blocks_allocated,
+                                                         true /** force size **/ );
+    if( ret_ptr == nullptr && 
+        ( ! data->magazine.empty() || ! data->deferred.runs.empty() ) )
+    {
+        /** we might be sitting on what we need, give it back and retry **/
+        ipc::buffer::flush_magazine( data );
+        global_blocks_allocated = request;
+        ret_ptr = ipc::buffer::global_buffer_allocate( data, 
+                                                       global_blocks_allocated,
+                                                       true /** force size **/ );
+    }
+    if( ret_ptr == nullptr )
+    {
+        /** 
+         * last go, hand back both local runs and ask for no more 
+         * than we need, the heap is tight so don't sit on anything.
+         */
+        ipc::buffer::free_channel_memory( data, info );
+        info.refill.target = ipc::refill_policy::min_blocks;
+        global_blocks_allocated = blocks;
+        ret_ptr = ipc::buffer::global_buffer_allocate( data, 
+                                                       global_blocks_allocated,
+                                                       true /** force size **/ );
+    }
+    if( ret_ptr == nullptr )
+    {
+        //global buffer allocate failed
+        return( false );
+    }
+    /** 
+     * keep the bigger of what's left of this run and the spare, 
+     * the smaller one goes back.
+     */
+    if( info.blocks_available > info.spare_blocks )
+    {
+        std::swap( info.local_allocation, info.spare_allocation );
+        std::swap( info.blocks_available, info.spare_blocks );
+    }
+    if( info.blocks_available > 0 )
+    {
+        ipc::buffer::_free( data, 
+                            info.local_allocation,
+                            info.blocks_available ); 
+    }
+    info.local_allocation = calculate_block_offset( &data->buffer->data, 
+                                                    ret_ptr ); 
+    info.blocks_available = global_blocks_allocated;
+    ipc::buffer::bind_blocks( data, 
+                              info.local_allocation, 
+                              info.blocks_available, 
+                              info.run_node );
+    return( true );
+}
+
+void*
+ipc::buffer::slab_allocate( ipc::thread_local_data      *data,
+                            ipc::local_allocation_info  &info,
+                            const std::size_t           nbytes )
+{
+    const auto  cls     = ipc::slab::size_class( nbytes );
+    auto        &cursor = info.slab[ cls ];
+    
+    ipc::slab_header *header = nullptr;
+    if( cursor.block != ipc::invalid_ptr_offset )
+    {
+        header = (ipc::slab_header*) 
+            ipc::buffer::translate_block( &data->buffer->data, cursor.block );
+        if( cursor.next == header->capacity )
+        {
+            /**
+             * if everything we handed out of this slab has already
+             * come back, just start over at the front. Only the owner
+             * ever increments the count, so zero here stays zero.
+             */
+            if( header->state.load( std::memory_order_acquire ) == 0 )
+            {
+                cursor.next = 0;
+            }
+            else
+            {
+                ipc::buffer::slab_release( data, header, true );
+                header          = nullptr;
+                cursor.block    = ipc::invalid_ptr_offset;
+            }
+        }
+    }
+    
+    if( header == nullptr )
+    {
+        /** 
+         * need a fresh block for a new slab, take a single allocation 
+         * block from the magazine if there is one, otherwise the local 
+         * allocation. Slabs only ever use the first base block of it.
+         **/
+        const auto slab_blocks = ipc::buffer::round_to_alloc_block( data, 1 );
+        if( data->magazine.pop( slab_blocks, cursor.block ) )
+        {
+            /** magazine blocks could be on any node, no-op without one **/
+            ipc::buffer::bind_blocks( data, cursor.block, slab_blocks, info.run_node );
+        }
+        else
+        {
+            if( info.blocks_available < slab_blocks && 
+                ! ipc::buffer::refill_local_allocation( data, info, slab_blocks ) )
+            {
+                return( nullptr );
+            }
+            cursor.block        = info.local_allocation;
+            info.local_allocation += slab_blocks;
+            info.blocks_available -= slab_blocks;
+        }
+        cursor.next         = 0;
+        
+        header = new ( ipc::buffer::translate_block( &data->buffer->data, cursor.block ) )
+            ipc::slab_header( ipc::slab::class_size( cls ),
+                              ipc::slab::class_capacity( cls ) );
+    }
+    header->state.fetch_add( 1, std::memory_order_acq_rel );
+    return( ipc::slab::get_record( header, cursor.next++ ) );
+}
+
+void
+ipc::buffer::slab_release( ipc::thread_local_data    *data,
+                           ipc::slab_header          *header,
+                           const bool                detach )
+{
+    bool last = false;
+    if( detach )
+    {
+        const auto prev = 
+            header->state.fetch_or( ipc::slab_header::detached, std::memory_order_acq_rel );
+        last = ( prev == 0 );
+    }
+    else
+    {
+        const auto prev = header->state.fetch_sub( 1, std::memory_order_acq_rel );
+        last = ( prev == ( ipc::slab_header::detached | 1 ) );
+    }
+    if( last )
+    {
+        ipc::buffer::magazine_free( data, 
+                                    ipc::buffer::calculate_block_offset( &data->buffer->data, header ),
+                                    ipc::buffer::round_to_alloc_block( data, 1 ) );
+    }
+}
+
+void
+ipc::buffer::free_slab_memory( ipc::thread_local_data *data, ipc::local_allocation_info &info )
+{
+    for( auto &cursor : info.slab )
+    {
+        if( cursor.block != ipc::invalid_ptr_offset )
+        {
+            auto *header = (ipc::slab_header*) 
+                ipc::buffer::translate_block( &data->buffer->data, cursor.block );
+            ipc::buffer::slab_release( data, header, true );
+        }
+        cursor.block = ipc::invalid_ptr_offset;
+        cursor.next  = 0;
+    }
 }
 
 void
@@ -771,8 +1262,12 @@ ipc::buffer::unlink_channel( ipc::thread_local_data *tls, ipc::channel_id_t chan
     ipc::channel_info *ch_ptr = tls->channel_map[ channel ];
     //get rid of our local data allocation, return to buffer
     auto &th_local_allocation = tls->channel_local_allocation[ channel ]; 
+    ipc::buffer::free_slab_memory( tls, th_local_allocation );
     ipc::buffer::free_channel_memory( tls, th_local_allocation );
-
+    if( th_local_allocation.dir == ipc::producer )
+    {
+        ipc::buffer::drain_recycle_lane( tls, ch_ptr );
+    }
     /**
      * Acquire semaphore, must go after allocate otherwise we have 
      * nested semaphore acquire and deadlock.
@@ -839,6 +1334,7 @@ ipc::buffer::unlink_channel( ipc::thread_local_data *tls, ipc::channel_id_t chan
     {
         case( ipc::spsc_record ):
         case( ipc::mpmc_record ):
+        case( ipc::spsc_data ):
         {
             const auto value_prod = 
                 ch_ptr->meta.ref_count_prod.load( std::memory_order_acquire );
@@ -846,6 +1342,8 @@ ipc::buffer::unlink_channel( ipc::thread_local_data *tls, ipc::channel_id_t chan
                 ch_ptr->meta.ref_count_cons.load( std::memory_order_acquire );
             if( value_prod  == 0 && value_cons == 0 )
             {
+                /** anything the consumer handed back after the producer left **/
+                ipc::buffer::drain_recycle_lane( tls, ch_ptr );
                 ipc::buffer::remove_channel( tls, channel );
             }
 
@@ -883,7 +1381,12 @@ ipc::buffer::unlink_channels( ipc::thread_local_data *tls )
         auto &th_local_allocation = tls->channel_local_allocation[ 
             ch_pair.first /** channel id **/ ];
 
+        ipc::buffer::free_slab_memory( tls, th_local_allocation );
         ipc::buffer::free_channel_memory( tls, th_local_allocation );
+        if( th_local_allocation.dir == ipc::producer )
+        {
+            ipc::buffer::drain_recycle_lane( tls, ch_ptr );
+        }
         /**
          * decrement refcount, if zero then free channel allocation, 
          * must get semaphore first.
@@ -948,6 +1451,8 @@ ipc::buffer::unlink_channels( ipc::thread_local_data *tls )
         const auto shd_val  = ch_ptr->meta.ref_count_shd.load( std::memory_order_acquire );
         if( prod_val == 0 && cons_val == 0 && shd_val == 0 )
         {
+            /** anything the consumer handed back after the producer left **/
+            ipc::buffer::drain_recycle_lane( tls, ch_ptr );
             ipc::buffer::remove_channel( tls, ch_pair.first );
         }
     }
@@ -977,19 +1482,12 @@ ipc::buffer::thread_local_allocate(
 
     /**
      * we've gotten here, so we know we should at least have enough 
-     * free memory to allocate the metadata structure + the requested
-     * user-visible data blocks (that's the parameter given in the
-     * function call.
-     */
-    ipc::buffer::create_meta_record( &data->buffer->data,
-                                     local_allocation, 
-                                     blocks_available,
-                                     blocks );
-    
-    /**
-     * get output pointer.
+     * free memory for the requested blocks, header included.
      */
-    output = ipc::buffer::translate_block( &data->buffer->data, local_allocation ); 
+    output = ipc::buffer::create_record_header( &data->buffer->data,
+                                                local_allocation, 
+                                                blocks,
+                                                channel_id );
 
     /**
      * now we need to go ahead an increment the local block count, not
@@ -1001,33 +1499,17 @@ ipc::buffer::thread_local_allocate(
     return( output );
 }
 
-void
-ipc::buffer::create_meta_record( void                    *data_buffer_start,
-                                 ipc::ptr_offset_t       &allocation_base,
-                                 std::size_t             &blocks_avail,
-                                 const std::size_t       multiple )
+void*
+ipc::buffer::create_record_header( void                    *data_buffer_start,
+                                   const ipc::ptr_offset_t allocation_base,
+                                   const std::size_t       blocks,
+                                   const ipc::channel_id_t channel_id )
 {
-    //we're here, we should have enough local mem
-    const auto meta_multiple = 
-        ipc::buffer::heap_t::get_block_multiple( sizeof( ipc::allocate_metadata ) );
-   
-
-    void *meta_alloc    = ipc::buffer::translate_block( data_buffer_start,
-                                                        allocation_base /** base offset **/ );
-    assert( meta_alloc != nullptr );                                                      
-    
-
-    //blocks are guaranteed to be sequential
-    allocation_base += meta_multiple;
-
-    //make an actual meta-data structure
-    new (meta_alloc) ipc::allocate_metadata( 
-        allocation_base  /** help the allocator find the base and de-allocate this block **/,
-        multiple         /** count of blocks allocated, not including this one **/
-    );
-
-    blocks_avail    -= meta_multiple; 
-    return;
+    void *block = ipc::buffer::translate_block( data_buffer_start,
+                                                allocation_base /** base offset **/ );
+    assert( block != nullptr );
+    auto *header = new (block) ipc::record_header( blocks, channel_id );
+    return( ipc::inline_header::get_record( header ) );
 }
 
 
@@ -1071,208 +1553,1133 @@ ipc::buffer::find_channel_block( ipc::thread_local_data *data,
     return( found_node_offset );
 }
 
-void*
-ipc::buffer::global_buffer_allocate( ipc::thread_local_data *data, 
-                                     std::size_t            &blocks_needed,
-                                     bool                   force_size )
+void
+ipc::buffer::return_blocks( ipc::thread_local_data  *data,
+                            const ipc::ptr_offset_t block_base,
+                            const std::size_t       blocks )
 {
-    /**
-     * if we're here we need to go out to the global buffer,
-     * then the calling function can call the thread local
-     * allocate function.
-     */
-    /**
-     * STEP 0: either allocate a multiple of our standard block size
-     * or if the nbytes requested is bigger, try to allocate something
-     * larger, as in 3x block size. 
-     */
-    const auto blocks_for_data = blocks_needed * 3;
-    
-    const auto large_block_multiple = 
-        ipc::buffer::heap_t::get_block_multiple( ipc::buffer::global_block_inc );
-   
-    /**
-     * STEP 1: calculate the multiple of increment size to allocate here.
-     */
-    const std::int64_t  block_usage_estimate = 
-        (blocks_for_data > large_block_multiple ? blocks_for_data : large_block_multiple );
-    
-    /**
-     * give the option to force the size to exactly the multiple specified
-     * and just assign it here.
-     */
-    blocks_needed = ( force_size ? blocks_needed : block_usage_estimate );
-
-
-    /**
-     * STEP 2: initialize output pointer.
-     */
-    void *output = nullptr;
-    
-    //get thread local version of allocate semaphore
-    /** LOCK **/
-    auto sem = data->allocate_semaphore;
-    if( ipc::sem::wait( sem ) == ipc::sem::uni_error )
-    {
-        ipc::buffer::gb_err.err_msg << 
-            "Failed to wait, plz debug at line (" << __LINE__ << ")" << 
-             " with sem value: " << sem;
-        shutdown_handler( 0 );
-    }
+    const auto shift    = ipc::buffer::alloc_block_shift( data );
+    auto       *heap    = 
+        ipc::buffer::get_heap( data, block_base >> ipc::extent_block_shift );
+    assert( heap != nullptr );
+    heap_t::return_n_blocks( ( block_base & ipc::extent_block_mask ) >> shift, 
+                             ipc::buffer::round_to_alloc_block( data, blocks ) >> shift,
+                             heap );
+}
 
-    if( blocks_needed <= ipc::meta_info::heap_t::get_blocks_avail( &data->buffer->heap  ) )
+ipc::buffer::heap_t*
+ipc::buffer::get_heap( ipc::thread_local_data *data,
+                       const std::uint8_t     extent )
+{
+    if( extent == 0 )
     {
-        /**
-         * STEP 3: set start pointer to the current free start
-         */
-        const auto block_base = ipc::meta_info::heap_t::get_n_blocks( blocks_needed,
-                                                                      &data->buffer->heap ); 
-        output = ipc::buffer::translate_block( (void *) &data->buffer->data,
-                                               block_base /** base offset **/ );
+        return( &data->buffer->heap );
     }
-    //if not the right size, go to sem_post and we end up here. 
-    
-    /** UNLOCK **/
-    if( ipc::sem::post( sem ) == ipc::sem::uni_error )
+    auto *extent_data = 
+        ipc::translate_helper::get_extent( &data->buffer->data, extent );
+    if( extent_data == nullptr )
     {
-        ipc::buffer::gb_err.err_msg << 
-            "Failed to post semaphore, exiting given we can't recover from this " << 
-                "sem val(" << sem << ") @ line " << __LINE__;
-        shutdown_handler( 0 );
+        return( nullptr );
     }
-    return( output /** null or valid pointer **/);
+    return( &ipc::extent_header::get_header( extent_data )->heap );
 }
 
-
-
-
-
 void*
-ipc::buffer::allocate_record( ipc::thread_local_data *data,
-                       const std::size_t      nbytes,
-                       const ipc::channel_id_t channel_id )
+ipc::buffer::map_extent( void *ctx, const std::uint8_t extent )
 {
-    assert( data != nullptr );
-    
-    /** check that channel exists for this tls structure **/ 
-    auto channel_found = data->channel_local_allocation.find( channel_id );
-    if( channel_found == data->channel_local_allocation.end() )
+    auto *b = reinterpret_cast< ipc::buffer* >( ctx );
+    if( extent >= b->extent_count.load( std::memory_order_acquire ) )
     {
         return( nullptr );
     }
-
-
-    //check minimum bytes for single allocation, requested + meta
-    const std::size_t meta_blocks  = 
-        heap_t::get_block_multiple( sizeof( ipc::allocate_metadata ) );
-    
-    std::size_t data_blocks  = 
-        heap_t::get_block_multiple( nbytes );
-
-    auto &th_local_allocation = (*channel_found).second;
-
-
-    if( (meta_blocks + data_blocks) <= th_local_allocation.blocks_available /** check thread local buffer **/)
+    auto *header( shm::eopen< ipc::extent_header >( b->extent_keys[ extent ] ) );
+    if( header == nullptr )
     {
-        //allocate from local buffer, this func calls meta builder func
+        return( nullptr );
+    }
+    while( header->cookie.load( std::memory_order_acquire ) 
+        != ipc::extent_header::cookie_in_use )
+    {
+        //spin while creator is setting things up.
+        __asm__ volatile( "nop" : : : );
+    }
+    ipc::buffer::advise_pages( ipc::extent_header::get_data( header ), 
+                               b->databuffer_size, 
+                               b->pages );
+    return( ipc::extent_header::get_data( header ) );
+}
+
+bool
+ipc::buffer::bind_blocks( ipc::thread_local_data  *data,
+                          const ipc::ptr_offset_t block_base,
+                          const std::size_t       blocks,
+                          const std::int32_t      node )
+{
+#if _IPC_USE_NUMA_ == 1 && defined( SYS_mbind )
+    if( node == ipc::any_numa_node || blocks == 0 )
+    {
+        return( true );
+    }
+    /** from linux/mempolicy.h, numaif.h isn't always installed **/
+    constexpr int           mpol_preferred  = 1;
+    constexpr unsigned      mpol_mf_move    = ( 1 << 1 );
+    constexpr std::size_t   mask_bits       = 1024;
+    if( node >= std::int32_t( mask_bits ) )
+    {
+        return( false );
+    }
+    std::uint64_t mask[ mask_bits / 64 ] = { 0 };
+    mask[ node / 64 ] = std::uint64_t( 1 ) << ( node % 64 );
+    void *addr = ipc::buffer::translate_block( &data->buffer->data, block_base );
+    return( syscall( SYS_mbind, 
+                     addr, 
+                     blocks << ipc::block_size_power_two, 
+                     mpol_preferred, 
+                     mask, 
+                     mask_bits, 
+                     mpol_mf_move ) == 0 );
+#else
+    UNUSED( data );
+    UNUSED( block_base );
+    UNUSED( blocks );
+    UNUSED( node );
+    return( node == ipc::any_numa_node );
+#endif
+}
+
+bool
+ipc::buffer::advise_pages( void                 *data,
+                           const std::size_t    bytes,
+                           const ipc::page_mode mode )
+{
+    if( mode != ipc::page_huge )
+    {
+        return( true );
+    }
+#ifdef MADV_HUGEPAGE
+    return( madvise( data, bytes, MADV_HUGEPAGE ) == 0 );
+#else
+    UNUSED( data );
+    UNUSED( bytes );
+    return( false );
+#endif
+}
+
+bool
+ipc::buffer::prefault( void                      *data,
+                       const std::size_t         bytes,
+                       const ipc::prefault_mode  mode,
+                       const std::uint8_t        threads,
+                       ipc::prefault_report      *report )
+{
+    ipc::prefault_report local_report;
+    auto &r( report != nullptr ? *report : local_report );
+    r.mode          = mode;
+    r.threads       = 0;
+    r.bytes_total   = bytes;
+    r.bytes_done    = 0;
+    r.elapsed       = std::chrono::microseconds( 0 );
+    if( mode == ipc::prefault_none || bytes == 0 )
+    {
+        return( true );
+    }
+    const auto start( std::chrono::steady_clock::now() );
+    auto *base( reinterpret_cast< std::uint8_t* >( data ) );
+    const auto page_bytes( static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) ) );
+
+    auto fault_chunk = [ page_bytes ]( const ipc::prefault_mode m, 
+                                       std::uint8_t             *ptr, 
+                                       const std::size_t        len ) -> bool
+    {
+        switch( m )
+        {
+            case( ipc::prefault_willneed ):
+                return( madvise( ptr, len, MADV_WILLNEED ) == 0 );
+            case( ipc::prefault_populate ):
+#ifdef MADV_POPULATE_WRITE
+                return( madvise( ptr, len, MADV_POPULATE_WRITE ) == 0 );
+#else
+                return( false );
+#endif
+            case( ipc::prefault_touch ):
+            {
+                /** write fault without changing anything somebody else put there **/
+                for( std::size_t offset( 0 ); offset < len; offset += page_bytes )
+                {
+                    __atomic_fetch_or( ptr + offset, 0, __ATOMIC_RELAXED );
+                }
+                return( true );
+            }
+            default:
+                return( false );
+        }
+    };
+
+    /** 
+     * do the first chunk here to find out if the kernel will populate
+     * (5.14+) before starting anybody else on it.
+     */
+    const auto chunk( ipc::prefault_report::chunk_bytes );
+    const auto first( std::min( chunk, bytes ) );
+    auto effective_mode( mode );
+    if( ! fault_chunk( effective_mode, base, first ) )
+    {
+        if( effective_mode != ipc::prefault_populate )
+        {
+            r.elapsed = std::chrono::duration_cast< std::chrono::microseconds >(
+                std::chrono::steady_clock::now() - start );
+            return( false );
+        }
+        effective_mode = ipc::prefault_touch;
+        fault_chunk( effective_mode, base, first );
+    }
+    r.mode = effective_mode;
+
+    std::atomic< std::size_t > next = { first };
+    std::atomic< std::size_t > done = { first };
+    auto worker = [&]( const bool report_progress )
+    {
+        for( ;; )
+        {
+            const auto offset( next.fetch_add( chunk, std::memory_order_relaxed ) );
+            if( offset >= bytes )
+            {
+                break;
+            }
+            const auto len( std::min( chunk, bytes - offset ) );
+            fault_chunk( effective_mode, base + offset, len );
+            const auto so_far( done.fetch_add( len, std::memory_order_relaxed ) + len );
+            if( report_progress && r.progress != nullptr )
+            {
+                r.bytes_done = so_far;
+                r.elapsed    = std::chrono::duration_cast< std::chrono::microseconds >(
+                    std::chrono::steady_clock::now() - start );
+                (*r.progress)( r, r.ctx );
+            }
+        }
+    };
+
+    const auto chunks( ( bytes + chunk - 1 ) / chunk );
+    std::size_t thread_count( threads != 0 ? threads : std::thread::hardware_concurrency() );
+    thread_count = std::max( std::size_t( 1 ), std::min( thread_count, chunks ) );
+    r.threads    = static_cast< std::uint8_t >( std::min( thread_count, std::size_t( 0xff ) ) );
+
+    std::vector< std::thread > pool;
+    for( std::size_t i( 1 ); i < thread_count; i++ )
+    {
+        pool.emplace_back( worker, false );
+    }
+    /** this thread works too, and is the only one that reports **/
+    worker( true );
+    for( auto &t : pool )
+    {
+        t.join();
+    }
+
+    r.bytes_done = done.load( std::memory_order_relaxed );
+    r.elapsed    = std::chrono::duration_cast< std::chrono::microseconds >(
+        std::chrono::steady_clock::now() - start );
+    if( r.progress != nullptr )
+    {
+        (*r.progress)( r, r.ctx );
+    }
+    return( true );
+}
+
+bool
+ipc::buffer::add_extent( ipc::thread_local_data *data,
+                         const std::uint8_t     seen_count )
+{
+    /** 
+     * locked heap callers already hold the alloc semaphore, the 
+     * lock-free heap doesn't need it to allocate but we still need 
+     * it so only one process grows the buffer at a time.
+     */
+    [[maybe_unused]] auto sem = data->allocate_semaphore;
+    if constexpr( heap_t::is_lock_free )
+    {
+        if( ipc::sem::wait( sem ) == ipc::sem::uni_error )
+        {
+            ipc::buffer::gb_err.err_msg << 
+                "Failed to wait, plz debug at line (" << __LINE__ << ")" << 
+                 " with sem value: " << sem;
+            shutdown_handler( 0 );
+        }
+    }
+    auto *b = data->buffer;
+    const auto extent = b->extent_count.load( std::memory_order_acquire );
+    if( extent == seen_count && extent < b->extent_limit )
+    {
+        /** 
+         * keys only need to be unique, keep going till we find one
+         * that nobody has used.
+         */
+        static std::atomic< int > extent_proj_id = { 0x7000 };
+        const auto  extent_bytes = 
+            ipc::extent_header::header_bytes + b->databuffer_size;
+        shm_key_t   key;
+        void        *memory = (void*)-1;
+        for( int attempt( 0 ); attempt < 64 && memory == (void*)-1; attempt++ )
+        {
+            ipc::buffer::gen_key( key, extent_proj_id.fetch_add( 1 ) );
+            memory = shm::init( key, extent_bytes, false /** don't zero **/, nullptr );
+        }
+        if( memory != (void*)-1 )
+        {
+            auto *header = new (memory) ipc::extent_header();
+            heap_t::initialize( &header->heap, 
+                                b->databuffer_size >> b->block_size_pow_two );
+            header->cookie.store( ipc::extent_header::cookie_in_use, 
+                                  std::memory_order_release );
+            shm::key_copy( b->extent_keys[ extent ], key );
+            b->extent_count.store( extent + 1, std::memory_order_release );
+            /** we map it back in lazily, same as everybody else **/
+            shm::close( key, &memory, extent_bytes, false, false );
+        }
+    }
+    const auto grown = 
+        ( b->extent_count.load( std::memory_order_acquire ) > seen_count );
+    if constexpr( heap_t::is_lock_free )
+    {
+        if( ipc::sem::post( sem ) == ipc::sem::uni_error )
+        {
+            ipc::buffer::gb_err.err_msg << 
+                "Failed to post semaphore, exiting given we can't recover from this " << 
+                    "sem val(" << sem << ") @ line " << __LINE__;
+            shutdown_handler( 0 );
+        }
+    }
+    return( grown );
+}
+
+std::uint8_t
+ipc::buffer::alloc_block_shift( const ipc::thread_local_data *data )
+{
+    return( data->buffer->block_size_pow_two - ipc::block_size_power_two );
+}
+
+std::size_t
+ipc::buffer::round_to_alloc_block( const ipc::thread_local_data *data,
+                                   const std::size_t            blocks )
+{
+    const std::size_t mask = 
+        ( std::size_t( 1 ) << ipc::buffer::alloc_block_shift( data ) ) - 1;
+    return( ( blocks + mask ) & ~mask );
+}
+
+void*
+ipc::buffer::global_buffer_allocate( ipc::thread_local_data *data, 
+                                     std::size_t            &blocks_needed,
+                                     bool                   force_size )
+{
+    /**
+     * if we're here we need to go out to the global buffer,
+     * then the calling function can call the thread local
+     * allocate function.
+     */
+    /**
+     * STEP 0: either allocate a multiple of our standard block size
+     * or if the nbytes requested is bigger, try to allocate something
+     * larger, as in 3x block size. 
+     */
+    const auto blocks_for_data = blocks_needed * 3;
+    
+    const auto large_block_multiple = 
+        ipc::buffer::heap_t::get_block_multiple( ipc::buffer::global_block_inc );
+   
+    /**
+     * STEP 1: calculate the multiple of increment size to allocate here.
+     */
+    const std::int64_t  block_usage_estimate = 
+        (blocks_for_data > large_block_multiple ? blocks_for_data : large_block_multiple );
+    
+    /**
+     * give the option to force the size to exactly the multiple specified
+     * and just assign it here.
+     */
+    blocks_needed = ( force_size ? blocks_needed : block_usage_estimate );
+    /** heap only deals in whole allocation blocks **/
+    blocks_needed = ipc::buffer::round_to_alloc_block( data, blocks_needed );
+    const auto shift = ipc::buffer::alloc_block_shift( data );
+
+
+    /**
+     * STEP 2: initialize output pointer.
+     */
+    void *output = nullptr;
+    
+    /** LOCK, lock-free heap doesn't need it **/
+    ipc::buffer::lock_heap( data );
+
+    /**
+     * STEP 3: set start pointer to the current free start, with 
+     * the lock-free heap the blocks available can change between
+     * checking and getting, so just go by what get_n_blocks says.
+     * Try the buffer first then each extent, if they're all full 
+     * and we're allowed to grow, map another extent and go again.
+     */
+    std::uint8_t extent = 0;
+    while( output == nullptr )
+    {
+        const auto extent_count = 
+            data->buffer->extent_count.load( std::memory_order_acquire );
+        for( ; output == nullptr && extent < extent_count; extent++ )
+        {
+            auto *heap = ipc::buffer::get_heap( data, extent );
+            if( heap == nullptr )
+            {
+                continue;
+            }
+            const auto block_base = 
+                ipc::meta_info::heap_t::get_n_blocks( blocks_needed >> shift, heap ); 
+            if( block_base >= 0 )
+            {
+                output = ipc::buffer::translate_block( (void *) &data->buffer->data,
+                    ( ipc::ptr_offset_t( extent ) << ipc::extent_block_shift ) | 
+                    ( ipc::ptr_offset_t( block_base ) << shift ) );
+                ipc::buffer::trim_mark_used( data, 
+                                             extent, 
+                                             std::size_t( block_base ) << shift, 
+                                             blocks_needed );
+            }
+        }
+        if( output != nullptr || 
+            extent_count >= data->buffer->extent_limit ||
+            ! ipc::buffer::add_extent( data, extent_count ) )
+        {
+            break;
+        }
+    }
+    if( output == nullptr )
+    {
+        data->buffer->stats.heap_failures.fetch_add( 1, std::memory_order_relaxed );
+    }
+    //if not the right size, go to sem_post and we end up here. 
+    
+    /** UNLOCK **/
+    ipc::buffer::unlock_heap( data );
+    return( output /** null or valid pointer **/);
+}
+
+
+
+
+
+void*
+ipc::buffer::allocate_record( ipc::thread_local_data *data,
+                       const std::size_t      nbytes,
+                       const ipc::channel_id_t channel_id,
+                       const std::int32_t     numa_node )
+{
+    std::size_t record_bytes = 0;
+    auto *ptr = 
+        ipc::buffer::_allocate_record( data, nbytes, channel_id, numa_node, record_bytes );
+    if( ptr == nullptr )
+    {
+        data->buffer->stats.failures.fetch_add( 1, std::memory_order_relaxed );
+        return( nullptr );
+    }
+    if( data->stats.count_alloc( record_bytes ) )
+    {
+        data->stats.flush( data->buffer->stats );
+    }
+    return( ptr );
+}
+
+void*
+ipc::buffer::_allocate_record( ipc::thread_local_data *data,
+                       const std::size_t      nbytes,
+                       const ipc::channel_id_t channel_id,
+                       const std::int32_t     numa_node,
+                       std::size_t            &record_bytes )
+{
+    assert( data != nullptr );
+    
+    /** check that channel exists for this tls structure **/ 
+    auto channel_found = data->channel_local_allocation.find( channel_id );
+    if( channel_found == data->channel_local_allocation.end() )
+    {
+        return( nullptr );
+    }
+
+
+    auto &th_local_allocation = (*channel_found).second;
+
+    /** channel has its own arena, only falls through if it's full **/
+    if( th_local_allocation.arena != nullptr )
+    {
+        auto *ptr = ipc::spsc_arena::allocate( th_local_allocation.arena,
+                                               th_local_allocation.arena_base,
+                                               nbytes );
+        if( ptr != nullptr )
+        {
+            record_bytes = ipc::spsc_arena::get_record_size( ptr );
+            return( ptr );
+        }
+    }
+
+#if _IPC_USE_NUMA_ == 1
+    /** 
+     * records (and slabs) come from wherever the local allocation is,
+     * if that's on the wrong node park it and take the node's own run,
+     * a new one gets bound on refill.
+     */
+    const auto node = ( numa_node != ipc::any_numa_node ? numa_node :
+        th_local_allocation.channel->meta.numa_node.load( std::memory_order_relaxed ) );
+    if( node != th_local_allocation.run_node )
+    {
+        ipc::buffer::switch_run_node( data, th_local_allocation, node );
+    }
+#else
+    UNUSED( numa_node );
+#endif
+
+    /** small records are packed into slabs **/
+    if( nbytes <= ipc::slab::max_record_size )
+    {
+        record_bytes = ipc::slab::class_size( ipc::slab::size_class( nbytes ) );
+        return( ipc::buffer::slab_allocate( data, th_local_allocation, nbytes ) );
+    }
+
+    /** 
+     * everything else gets whole blocks with the header at the front
+     * of the first one, has to cover whole allocation blocks otherwise
+     * the next record carved from the local run isn't aligned to one.
+     */
+    const std::size_t record_blocks = 
+        ipc::buffer::round_to_alloc_block( data, 
+            heap_t::get_block_multiple( nbytes + ipc::inline_header::header_size ) );
+    record_bytes = 
+        ( record_blocks << ipc::block_size_power_two ) - ipc::inline_header::header_size;
+
+    ipc::ptr_offset_t   recycled_base   = ipc::invalid_ptr_offset;
+    /** 
+     * records the consumer handed back come first, anything that's
+     * the wrong size is ours now so it goes to the magazine.
+     */
+    auto *lane = th_local_allocation.recycle;
+    if( lane != nullptr && lane->enabled.load( std::memory_order_relaxed ) )
+    {
+        while( lane->pop( recycled_base ) )
+        {
+            auto *header = (ipc::record_header*)
+                ipc::buffer::translate_block( &data->buffer->data, recycled_base );
+            if( header->block_count == record_blocks )
+            {
+                return( ipc::buffer::create_record_header( &data->buffer->data,
+                                                           recycled_base,
+                                                           record_blocks,
+                                                           channel_id ) );
+            }
+            ipc::buffer::magazine_free( data, recycled_base, header->block_count );
+        }
+    }
+
+    /** check for a run of exactly this size that we freed earlier **/
+    if( data->magazine.pop( record_blocks, recycled_base ) )
+    {
+        return( ipc::buffer::create_record_header( &data->buffer->data,
+                                                   recycled_base,
+                                                   record_blocks,
+                                                   channel_id ) );
+    }
+
+    /**
+     * bigger than a single heap leaf, a thread local run sized
+     * at 3x this would be a huge waste, go to the heap for exactly
+     * the span we need and leave the local run alone.
+     */
+    if( record_blocks > 
+            ( std::size_t( heap_t::blocksize_bits ) << ipc::buffer::alloc_block_shift( data ) ) )
+    {
+        std::size_t span_blocks = record_blocks;
+        auto *span_ptr = ipc::buffer::global_buffer_allocate( data,
+                                                              span_blocks,
+                                                              true /** force size **/ );
+        if( span_ptr == nullptr && 
+            ( ! data->magazine.empty() || ! data->deferred.runs.empty() ) )
+        {
+            ipc::buffer::flush_magazine( data );
+            span_blocks = record_blocks;
+            span_ptr = ipc::buffer::global_buffer_allocate( data,
+                                                            span_blocks,
+                                                            true /** force size **/ );
+        }
+        if( span_ptr == nullptr )
+        {
+            return( nullptr );
+        }
+        ipc::buffer::bind_blocks( data, 
+                                  calculate_block_offset( &data->buffer->data, span_ptr ),
+                                  span_blocks,
+                                  th_local_allocation.run_node );
+        record_bytes = 
+            ( span_blocks << ipc::block_size_power_two ) - ipc::inline_header::header_size;
+        return( ipc::buffer::create_record_header( 
+                    &data->buffer->data,
+                    calculate_block_offset( &data->buffer->data, span_ptr ),
+                    span_blocks,
+                    channel_id ) );
+    }
+
+    if( record_blocks <= th_local_allocation.blocks_available /** check thread local buffer **/)
+    {
+        //allocate from local buffer, this func calls meta builder func
         return( 
             ipc::buffer::thread_local_allocate(
-                data, data_blocks, channel_id
+                data, record_blocks, channel_id
             )
         );
     }
-    /** free data that is previously there **/
-    
-    ipc::buffer::free_channel_memory( data, th_local_allocation );
+    
+    if( ! ipc::buffer::refill_local_allocation( data, 
+                                                th_local_allocation, 
+                                                record_blocks ) )
+    {
+        //global buffer allocate failed
+        return( nullptr );
+    }
+    /**
+     * call normal allocate given we now have memory to give 
+     * back, this will set up the header. 
+     */
+    return( 
+        ipc::buffer::thread_local_allocate(
+            data, record_blocks, channel_id
+        ) );
+}
+
+
+void
+ipc::buffer::_free(   ipc::thread_local_data *data,
+                      const ipc::ptr_offset_t block_base,
+                      const std::size_t       blocks )
+{
+    /** LOCK, lock-free heap doesn't need it **/
+    ipc::buffer::lock_heap( data );
+    
+    /**
+     * FIXME - need to formalize the allocate vs. send policy. 
+     * we want to be able to allocate thread local blocks while
+     * being able to allocate locally and still send records without
+     * having to re-acquire the semaphore.
+     */
+    ipc::buffer::return_blocks( data, block_base, blocks );
+    
+    /** UNLOCK **/
+    ipc::buffer::unlock_heap( data );
+    /** if it's on and it's been long enough **/
+    ipc::buffer::trim( data );
+}
+
+
+void
+ipc::buffer::free_record(   ipc::thread_local_data *data,
+                            void *ptr )
+{
+    ipc::buffer::release_record( data, ptr, false );
+}
+
+void
+ipc::buffer::free_records(  ipc::thread_local_data *data,
+                            void **records,
+                            const std::size_t count )
+{
+    for( std::size_t i( 0 ); i < count; i++ )
+    {
+        ipc::buffer::release_record( data, records[ i ], true );
+    }
+    if( data->magazine.over_high_water() || data->magazine.idle() )
+    {
+        ipc::buffer::flush_magazine( data );
+    }
+    else if( ! data->deferred.enabled() || data->deferred.due() )
+    {
+        ipc::buffer::flush_deferred( data );
+    }
+}
+
+void
+ipc::buffer::release_record( ipc::thread_local_data *data,
+                             void *ptr,
+                             const bool batch )
+{
+    if( ipc::inline_header::has_header( ptr ) )
+    {
+        if( ipc::buffer::is_arena_record( data, ptr ) )
+        {
+            ipc::buffer::count_free( data, ipc::spsc_arena::get_record_size( ptr ) );
+            ipc::spsc_arena::release( ptr );
+            return;
+        }
+        if( ipc::inline_header::get_kind( ptr ) == ipc::kind_slab )
+        {
+            auto *slab_header = ipc::slab::get_header( ptr );
+            ipc::buffer::count_free( data, slab_header->record_size );
+            ipc::buffer::slab_release( data, slab_header, false );
+            return;
+        }
+        auto *header = ipc::inline_header::get_header( ptr );
+        assert( header->kind == ipc::kind_record );
+        ipc::buffer::count_free( data, 
+            ( header->block_count << ipc::block_size_power_two ) - ipc::inline_header::header_size );
+        if( ipc::buffer::recycle_record( data, header ) )
+        {
+            return;
+        }
+        ipc::buffer::magazine_free( data, 
+                                    calculate_block_offset( &data->buffer->data, header ),
+                                    header->block_count,
+                                    batch );
+        return;
+    }
+    /** channels, get number of blocks for the metadata **/
+    auto data_block_offset  = calculate_block_offset( &data->buffer->data, ptr );
+    
+    const auto meta_multiple = 
+        ipc::buffer::heap_t::get_block_multiple( sizeof( ipc::allocate_metadata ) );
+   
+    auto meta_offset = data_block_offset - meta_multiple;
+
+    auto *meta_data = (ipc::allocate_metadata*)
+        ipc::buffer::translate_block( &data->buffer->data, meta_offset);
+    
+    const auto blocks_to_free = meta_multiple + meta_data->block_count;
+    ipc::buffer::count_free( data, meta_data->block_count << ipc::block_size_power_two );
+    
+    ipc::buffer::magazine_free( data, 
+                                meta_offset,
+                                blocks_to_free,
+                                batch );
+
+    return;
+}
+
+bool
+ipc::buffer::is_arena_record( ipc::thread_local_data *data,
+                              const void             *ptr )
+{
+    return( data->buffer->arenas.contains( 
+        calculate_block_offset( &data->buffer->data, ptr ) ) );
+}
+
+bool
+ipc::buffer::recycle_record( ipc::thread_local_data *data,
+                             ipc::record_header     *header )
+{
+    const auto info_found = data->channel_local_allocation.find( header->channel );
+    if( info_found == data->channel_local_allocation.end() || 
+        (*info_found).second.dir != ipc::consumer )
+    {
+        return( false );
+    }
+    auto *channel = data->channel_map[ header->channel ];
+    if( ! channel->recycle.enabled.load( std::memory_order_relaxed ) )
+    {
+        return( false );
+    }
+    return( channel->recycle.push( 
+        calculate_block_offset( &data->buffer->data, header ) ) );
+}
+
+void
+ipc::buffer::drain_recycle_lane( ipc::thread_local_data *data,
+                                 ipc::channel_info      *channel )
+{
+    ipc::ptr_offset_t block = ipc::invalid_ptr_offset;
+    while( channel->recycle.pop( block ) )
+    {
+        auto *header = (ipc::record_header*)
+            ipc::buffer::translate_block( &data->buffer->data, block );
+        ipc::buffer::magazine_free( data, block, header->block_count );
+    }
+}
+
+bool
+ipc::buffer::enable_recycling( ipc::thread_local_data *tls,
+                               const channel_id_t     channel_id )
+{
+    auto channel_found = tls->channel_map.find( channel_id );
+    if( channel_found == tls->channel_map.end() || 
+        (*channel_found).second->meta.type != ipc::spsc_record )
+    {
+        return( false );
+    }
+    (*channel_found).second->recycle.enabled.store( true, std::memory_order_release );
+    return( true );
+}
+
+void
+ipc::buffer::magazine_free( ipc::thread_local_data *data,
+                            const ipc::ptr_offset_t block_base,
+                            const std::size_t       blocks,
+                            const bool              batch )
+{
+    if( ! data->magazine.push( block_base, blocks ) )
+    {
+        if( ! batch && ! data->deferred.enabled() )
+        {
+            ipc::buffer::_free( data, block_base, blocks );
+            return;
+        }
+        /** 
+         * round now, once coalesced the rounding in return_blocks 
+         * would only apply to the end of the merged run.
+         */
+        data->deferred.push( block_base, 
+                             ipc::buffer::round_to_alloc_block( data, blocks ) );
+    }
+    if( batch )
+    {
+        return;
+    }
+    if( data->magazine.over_high_water() || data->magazine.idle() )
+    {
+        ipc::buffer::flush_magazine( data );
+    }
+    else if( data->deferred.due() )
+    {
+        ipc::buffer::flush_deferred( data );
+    }
+}
+
+void
+ipc::buffer::set_deferred_free( ipc::thread_local_data          *data,
+                                const std::size_t               max_records,
+                                const std::chrono::microseconds max_age )
+{
+    data->deferred.max_records  = max_records;
+    data->deferred.max_age      = max_age;
+    if( ! data->deferred.enabled() )
+    {
+        ipc::buffer::flush_deferred( data );
+    }
+}
+
+void
+ipc::buffer::flush_deferred( ipc::thread_local_data *data )
+{
+    ipc::buffer::return_runs( data, data->deferred.runs );
+}
+
+void
+ipc::buffer::flush_magazine( ipc::thread_local_data *data )
+{
+    if( data->magazine.empty() && data->deferred.runs.empty() )
+    {
+        return;
+    }
+    /** everything goes back in one pass, deferred runs included **/
+    auto &runs = data->deferred.runs;
+    for( const auto &run : data->magazine.runs )
+    {
+        for( const auto block_base : run.second )
+        {
+            runs.emplace_back( block_base, 
+                               ipc::buffer::round_to_alloc_block( data, run.first ) );
+        }
+    }
+    ipc::buffer::return_runs( data, runs );
+    data->magazine.runs.clear();
+    data->magazine.cached_blocks = 0;
+}
+
+void
+ipc::buffer::lock_heap( ipc::thread_local_data *data )
+{
+    if constexpr( ! heap_t::is_lock_free )
+    {
+        auto sem = data->allocate_semaphore;
+        /** uncontended, nothing to time or count **/
+        if( ipc::sem::try_wait( sem ) == 0 )
+        {
+            return;
+        }
+        const auto start( std::chrono::steady_clock::now() );
+        if( ipc::sem::wait( sem ) == ipc::sem::uni_error )
+        {
+            ipc::buffer::gb_err.err_msg << 
+                "Failed to wait, plz debug at line (" << __LINE__ << ")" << 
+                 " with sem value: " << sem;
+            shutdown_handler( 0 );
+        }
+        const auto waited = std::chrono::duration_cast< std::chrono::nanoseconds >( 
+            std::chrono::steady_clock::now() - start ).count();
+        if( data->stats.count_sem_wait( waited ) )
+        {
+            data->stats.flush( data->buffer->stats );
+        }
+    }
+    else
+    {
+        UNUSED( data );
+    }
+}
+
+void
+ipc::buffer::unlock_heap( ipc::thread_local_data *data )
+{
+    if constexpr( ! heap_t::is_lock_free )
+    {
+        auto sem = data->allocate_semaphore;
+        if( ipc::sem::post( sem ) == ipc::sem::uni_error )
+        {
+            ipc::buffer::gb_err.err_msg << 
+                "Failed to post semaphore, exiting given we can't recover from this " << 
+                    "sem val(" << sem << ") @ line " << __LINE__;
+            shutdown_handler( 0 );
+        }
+    }
+    else
+    {
+        UNUSED( data );
+    }
+}
+
+void
+ipc::buffer::count_free( ipc::thread_local_data *data, const std::size_t bytes )
+{
+    if( data->stats.count_free( bytes ) )
+    {
+        data->stats.flush( data->buffer->stats );
+    }
+}
 
-    /** else allocate from global buffer **/
-    std::size_t global_blocks_allocated = data_blocks;;
-    auto *ret_ptr = ipc::buffer::global_buffer_allocate( data, 
-                                                         global_blocks_allocated );
-    if( ret_ptr == nullptr )
+void
+ipc::buffer::get_stats( ipc::thread_local_data       *data,
+                        ipc::alloc_stats_snapshot    &out )
+{
+    auto *b = data->buffer;
+    data->stats.flush( b->stats );
+    out = ipc::alloc_stats_snapshot();
+    for( std::size_t i( 0 ); i < ipc::alloc_stats::size_buckets; i++ )
     {
-        //global buffer allocate failed
-        return( nullptr );
+        out.allocs[ i ] = b->stats.allocs[ i ].load( std::memory_order_relaxed );
+        out.frees[ i ]  = b->stats.frees[ i ].load( std::memory_order_relaxed );
     }
-    
-    
-    th_local_allocation.local_allocation = calculate_block_offset( &data->buffer->data, 
-                                                                   ret_ptr ); 
-    th_local_allocation.blocks_available = global_blocks_allocated;
-    /**
-     * call normal allocate given we now have memory to give 
-     * back, this will set up the meta header. 
-     */
-    return( 
-        ipc::buffer::thread_local_allocate(
-            data, data_blocks, channel_id
-        ) );
-    return( nullptr );
+    out.failures        = b->stats.failures.load( std::memory_order_relaxed );
+    out.heap_failures   = b->stats.heap_failures.load( std::memory_order_relaxed );
+    out.sem_waits       = b->stats.sem_waits.load( std::memory_order_relaxed );
+    out.sem_wait_ns     = b->stats.sem_wait_ns.load( std::memory_order_relaxed );
+    out.trim_scans      = b->stats.trim_scans.load( std::memory_order_relaxed );
+    out.reclaimed_bytes = b->stats.reclaimed_bytes.load( std::memory_order_relaxed );
+
+    /** heap blocks are allocation blocks, see buffer_config **/
+    const auto block_shift = b->block_size_pow_two;
+    auto count_run = [&]( const std::uint64_t start, const std::uint64_t length )
+    {
+        UNUSED( start );
+        const auto bytes = std::size_t( length ) << block_shift;
+        out.free_runs[ ipc::alloc_stats::run_bucket( bytes ) ]++;
+        out.largest_free_run = std::max( out.largest_free_run, bytes );
+    };
+    ipc::buffer::lock_heap( data );
+    const auto extent_count = b->extent_count.load( std::memory_order_acquire );
+    for( std::uint8_t extent( 0 ); extent < extent_count; extent++ )
+    {
+        auto *heap = ipc::buffer::get_heap( data, extent );
+        if( heap == nullptr )
+        {
+            continue;
+        }
+        out.total_bytes += heap_t::get_total_blocks( heap ) << block_shift;
+        out.free_bytes  += heap_t::get_current_free( heap ) << block_shift;
+        heap_t::for_each_free_run( heap, count_run );
+    }
+    ipc::buffer::unlock_heap( data );
 }
 
+std::size_t
+ipc::buffer::trim( ipc::thread_local_data *data, const bool force )
+{
+    if constexpr( heap_t::is_lock_free )
+    {
+        UNUSED( data );
+        UNUSED( force );
+        return( 0 );
+    }
+    else
+    {
+        auto *b     = data->buffer;
+        auto &state = b->trim_info;
+        const auto idle = state.idle_ns.load( std::memory_order_relaxed );
+        if( idle == 0 && ! force )
+        {
+            return( 0 );
+        }
+        const std::int64_t now = std::chrono::duration_cast< std::chrono::nanoseconds >( 
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+        if( ! force && ( now - state.last_scan_ns.load( std::memory_order_relaxed ) ) < idle )
+        {
+            return( 0 );
+        }
+        if( state.busy.exchange( true, std::memory_order_acquire ) )
+        {
+            return( 0 );
+        }
+        state.last_scan_ns.store( now, std::memory_order_relaxed );
+        
+        std::size_t reclaimed = 0;
+        ipc::buffer::lock_heap( data );
+        const auto extent_count = b->extent_count.load( std::memory_order_acquire );
+        for( std::uint8_t extent( 0 ); extent < extent_count; extent++ )
+        {
+            if( extent == 0 )
+            {
+                reclaimed += ipc::buffer::trim_heap( &b->heap, 
+                                                     &b->data, 
+                                                     state.map, 
+                                                     b->block_size_pow_two, 
+                                                     force );
+                continue;
+            }
+            auto *extent_data = 
+                ipc::translate_helper::get_extent( &b->data, extent );
+            if( extent_data == nullptr )
+            {
+                continue;
+            }
+            auto *header = ipc::extent_header::get_header( extent_data );
+            reclaimed += ipc::buffer::trim_heap( &header->heap, 
+                                                 extent_data, 
+                                                 header->trim, 
+                                                 b->block_size_pow_two, 
+                                                 force );
+        }
+        ipc::buffer::unlock_heap( data );
+        state.busy.store( false, std::memory_order_release );
+
+        b->stats.trim_scans.fetch_add( 1, std::memory_order_relaxed );
+        b->stats.reclaimed_bytes.fetch_add( reclaimed, std::memory_order_relaxed );
+        return( reclaimed );
+    }
+}
 
 void
-ipc::buffer::_free(   ipc::thread_local_data *data,
-                      const ipc::ptr_offset_t block_base,
-                      const std::size_t       blocks )
+ipc::buffer::trim_mark_used( ipc::thread_local_data *data,
+                             const std::uint8_t     extent,
+                             const std::size_t      block_base,
+                             const std::size_t      blocks )
 {
-    /** LOCK **/
-    auto sem = data->allocate_semaphore;
-    if( ipc::sem::wait( sem ) == ipc::sem::uni_error )
+    if constexpr( ! heap_t::is_lock_free )
     {
-        ipc::buffer::gb_err.err_msg << 
-            "Failed to wait, plz debug at line (" << __LINE__ << ")" << 
-             " with sem value: " << sem;
-        shutdown_handler( 0 );
+        ipc::trim_map *map = nullptr;
+        if( extent == 0 )
+        {
+            map = &data->buffer->trim_info.map;
+        }
+        else
+        {
+            auto *extent_data = 
+                ipc::translate_helper::get_extent( &data->buffer->data, extent );
+            if( extent_data == nullptr )
+            {
+                return;
+            }
+            map = &ipc::extent_header::get_header( extent_data )->trim;
+        }
+        constexpr auto shift = ipc::trim_map::granule_pow_two - ipc::block_size_power_two;
+        const auto end = std::min( ( block_base + blocks + ( std::size_t( 1 ) << shift ) - 1 ) >> shift,
+                                   ipc::trim_map::max_granules );
+        for( auto g( block_base >> shift ); g < end; g++ )
+        {
+            const auto bit = ~( std::uint64_t( 1 ) << ( g & 63 ) );
+            map->seen_free[ g >> 6 ] &= bit;
+            map->trimmed[ g >> 6 ]   &= bit;
+        }
     }
-    
-    /**
-     * FIXME - need to formalize the allocate vs. send policy. 
-     * we want to be able to allocate thread local blocks while
-     * being able to allocate locally and still send records without
-     * having to re-acquire the semaphore.
-     */
-    heap_t::return_n_blocks( block_base, 
-                             blocks,
-                             &data->buffer->heap );
-   
-    //HERE
-    
-    /** UNLOCK **/
-    if( ipc::sem::post( sem ) == ipc::sem::uni_error )
+    else
     {
-        ipc::buffer::gb_err.err_msg << 
-            "Failed to post semaphore, exiting given we can't recover from this " << 
-                "sem val(" << sem << ") @ line " << __LINE__;
-        shutdown_handler( 0 );
+        UNUSED( data );
+        UNUSED( extent );
+        UNUSED( block_base );
+        UNUSED( blocks );
     }
-
 }
 
+std::size_t
+ipc::buffer::trim_heap( heap_t               *heap,
+                        void                 *base,
+                        ipc::trim_map        &map,
+                        const std::uint8_t   block_shift,
+                        const bool           force )
+{
+    constexpr auto granule_pow_two = ipc::trim_map::granule_pow_two;
+    /** granules the heap has entirely free right now **/
+    std::uint64_t free_now[ ipc::trim_map::words ] = {};
+    heap_t::for_each_free_run( heap, 
+        [&]( const std::uint64_t start, const std::uint64_t length )
+        {
+            const auto first_byte   = std::size_t( start ) << block_shift;
+            const auto end_byte     = first_byte + ( std::size_t( length ) << block_shift );
+            const auto first        = 
+                ( first_byte + ipc::trim_map::granule_bytes - 1 ) >> granule_pow_two;
+            const auto end          = end_byte >> granule_pow_two;
+            for( auto g( first ); g < end && g < ipc::trim_map::max_granules; g++ )
+            {
+                free_now[ g >> 6 ] |= ( std::uint64_t( 1 ) << ( g & 63 ) );
+            }
+        } );
+
+    std::size_t reclaimed = 0;
+    for( std::size_t w( 0 ); w < ipc::trim_map::words; w++ )
+    {
+        /** free for two scans in a row (or now if forced) and still resident **/
+        auto candidates = free_now[ w ] & ~map.trimmed[ w ];
+        if( ! force )
+        {
+            candidates &= map.seen_free[ w ];
+        }
+        /** anything handed out since is resident again **/
+        map.trimmed[ w ]   &= free_now[ w ];
+        map.seen_free[ w ]  = free_now[ w ];
+        while( candidates != 0 )
+        {
+            const auto bit = __builtin_ctzll( candidates );
+            candidates &= ( candidates - 1 );
+            auto *ptr = reinterpret_cast< ipc::byte_t* >( base ) + 
+                ( ( ( w << 6 ) + bit ) << granule_pow_two );
+            bool ok = false;
+#ifdef MADV_REMOVE
+            /** frees the shared memory backing, not just our mapping of it **/
+            ok = ( madvise( ptr, ipc::trim_map::granule_bytes, MADV_REMOVE ) == 0 );
+#endif
+            if( ! ok )
+            {
+                /** drops it from this process at least **/
+                ok = ( madvise( ptr, ipc::trim_map::granule_bytes, MADV_DONTNEED ) == 0 );
+            }
+            if( ok )
+            {
+                map.trimmed[ w ] |= ( std::uint64_t( 1 ) << bit );
+                reclaimed += ipc::trim_map::granule_bytes;
+            }
+        }
+    }
+    return( reclaimed );
+}
 
 void
-ipc::buffer::free_record(   ipc::thread_local_data *data,
-                            void *ptr )
+ipc::buffer::return_runs( ipc::thread_local_data          *data,
+                          std::vector< ipc::block_run_t > &runs )
 {
+    if( runs.empty() )
+    {
+        return;
+    }
+    ipc::deferred_free::coalesce( runs );
+    /** LOCK, lock-free heap doesn't need it **/
+    ipc::buffer::lock_heap( data );
     
-    /** get number of blocks for the metadata **/
-    auto data_block_offset  = calculate_block_offset( &data->buffer->data, ptr );
-    
-    const auto meta_multiple = 
-        ipc::buffer::heap_t::get_block_multiple( sizeof( ipc::allocate_metadata ) );
-   
-    auto meta_offset = data_block_offset - meta_multiple;
-
-    auto *meta_data = (ipc::allocate_metadata*)
-        ipc::buffer::translate_block( &data->buffer->data, meta_offset);
-    
-    const auto blocks_to_free = meta_multiple + meta_data->block_count;
+    for( const auto &run : runs )
+    {
+        ipc::buffer::return_blocks( data, run.first, run.second );
+    }
     
-    ipc::buffer::_free( data, 
-                        meta_offset,
-                        blocks_to_free );
-
-    return;
+    /** UNLOCK **/
+    ipc::buffer::unlock_heap( data );
+    runs.clear();
+    ipc::buffer::trim( data );
 }
 
 
@@ -1406,6 +2813,242 @@ ipc::buffer::receive_record( ipc::thread_local_data *tls_data,
     return( ret_code ); 
 }
 
+ipc::tx_code
+ipc::buffer::send_data( ipc::thread_local_data *tls_data,
+                        const ipc::channel_id_t channel_id,
+                        const void             *bytes,
+                        const std::size_t      length )
+{
+    assert( tls_data != nullptr );
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    auto *channel_info = (*channel_found).second;  
+    if( channel_info->meta.type != ipc::spsc_data ||
+        length > ipc::buffer::spsc_data::max_message( channel_info ) )
+    {
+        return( ipc::tx_error );
+    }
+    return( ipc::buffer::spsc_data::push( channel_info, 
+                                          bytes, 
+                                          length, 
+                                          &tls_data->buffer->data ) );
+}
+
+ipc::tx_code
+ipc::buffer::receive_data( ipc::thread_local_data *tls_data,
+                           const ipc::channel_id_t channel_id,
+                           void                   *bytes,
+                           const std::size_t      capacity,
+                           std::size_t            &length )
+{
+    assert( tls_data != nullptr );
+    length = 0;
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    auto *channel_info = (*channel_found).second;  
+    if( channel_info->meta.type != ipc::spsc_data )
+    {
+        return( ipc::tx_error );
+    }
+    return( ipc::buffer::spsc_data::pop( channel_info, 
+                                         bytes, 
+                                         capacity, 
+                                         length,
+                                         &tls_data->buffer->data ) );
+}
+
+ipc::tx_code
+ipc::buffer::reserve_data( ipc::thread_local_data *tls_data,
+                           const ipc::channel_id_t channel_id,
+                           const std::size_t      length,
+                           void                   **span )
+{
+    assert( tls_data != nullptr );
+    *span = nullptr;
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    auto *channel_info = (*channel_found).second;  
+    if( channel_info->meta.type != ipc::spsc_data )
+    {
+        return( ipc::tx_error );
+    }
+    /** drops any reserve before it, the one that's too big included **/
+    *span = ipc::buffer::spsc_data::reserve( channel_info, 
+                                             length, 
+                                             &tls_data->buffer->data );
+    if( *span != nullptr )
+    {
+        return( ipc::tx_success );
+    }
+    return( length > ipc::buffer::spsc_data::max_message( channel_info ) ? 
+                ipc::tx_error : ipc::tx_retry );
+}
+
+ipc::tx_code
+ipc::buffer::commit_data( ipc::thread_local_data *tls_data,
+                          const ipc::channel_id_t channel_id,
+                          const std::size_t      length )
+{
+    assert( tls_data != nullptr );
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    auto *channel_info = (*channel_found).second;  
+    if( channel_info->meta.type != ipc::spsc_data ||
+        ! ipc::buffer::spsc_data::commit( channel_info, 
+                                          length, 
+                                          &tls_data->buffer->data ) )
+    {
+        return( ipc::tx_error );
+    }
+    return( ipc::tx_success );
+}
+
+ipc::tx_code
+ipc::buffer::peek_data( ipc::thread_local_data *tls_data,
+                        const ipc::channel_id_t channel_id,
+                        const void             **span,
+                        std::size_t            &length )
+{
+    assert( tls_data != nullptr );
+    *span  = nullptr;
+    length = 0;
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    auto *channel_info = (*channel_found).second;  
+    if( channel_info->meta.type != ipc::spsc_data )
+    {
+        return( ipc::tx_error );
+    }
+    *span = ipc::buffer::spsc_data::peek( channel_info, 
+                                          length, 
+                                          &tls_data->buffer->data );
+    return( *span == nullptr ? ipc::tx_retry : ipc::tx_success );
+}
+
+ipc::tx_code
+ipc::buffer::release_data( ipc::thread_local_data *tls_data,
+                           const ipc::channel_id_t channel_id )
+{
+    assert( tls_data != nullptr );
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    auto *channel_info = (*channel_found).second;  
+    if( channel_info->meta.type != ipc::spsc_data ||
+        ! ipc::buffer::spsc_data::release( channel_info, &tls_data->buffer->data ) )
+    {
+        return( ipc::tx_error );
+    }
+    return( ipc::tx_success );
+}
+
+ipc::tx_code
+ipc::buffer::send_records( ipc::thread_local_data  *tls_data,
+                           const ipc::channel_id_t channel_id,
+                           void                    **records,
+                           const std::size_t       count,
+                           std::size_t             &sent )
+{
+    assert( tls_data != nullptr );
+    sent = 0;
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    if( count == 0 )
+    {
+        return( ipc::tx_success );
+    }
+    auto *channel_info = (*channel_found).second;  
+    auto *base         = &tls_data->buffer->data;
+    
+    switch( channel_info->meta.type )
+    {
+        case( ipc::mpmc_record ):
+        {
+            /** 
+             * the mpmc queue links nodes by block offset, neither the
+             * nodes nor the records are block aligned, no batches.
+             */
+            return( ipc::tx_error );
+        }
+        break;
+        case( ipc::spsc_record ):
+        {
+            sent = ipc::buffer::spsc_lock_free::push_n( channel_info, 
+                                                        records, 
+                                                        count, 
+                                                        base );
+            return( sent > 0 ? ipc::tx_success : ipc::tx_retry );
+        }
+        break;
+        default:
+            assert( false );
+    }
+    return( ipc::tx_error );
+}
+
+ipc::tx_code
+ipc::buffer::receive_records( ipc::thread_local_data  *tls_data,
+                              const ipc::channel_id_t channel_id,
+                              void                    **records,
+                              const std::size_t       count,
+                              std::size_t             &received )
+{
+    assert( tls_data != nullptr );
+    received = 0;
+    auto channel_found = tls_data->channel_map.find( channel_id );
+    if( channel_found == tls_data->channel_map.end() )
+    {
+        return( ipc::no_such_channel );
+    }
+    if( count == 0 )
+    {
+        return( ipc::tx_success );
+    }
+    auto *channel_info = (*channel_found).second;  
+    auto *base         = &tls_data->buffer->data;
+    
+    switch( channel_info->meta.type )
+    {
+        case( ipc::mpmc_record ):
+        {
+            /** see send_records **/
+            return( ipc::tx_error );
+        }
+        break;
+        case( ipc::spsc_record ):
+        {
+            received = ipc::buffer::spsc_lock_free::pop_n( channel_info, 
+                                                           records, 
+                                                           count, 
+                                                           base );
+        }
+        break;
+        default:
+            assert( false );
+    }
+    return( received > 0 ? ipc::tx_success : ipc::tx_retry );
+}
+
 
 
 ipc::thread_local_data*
@@ -1455,6 +3098,8 @@ ipc::buffer::get_tls_structure( ipc::buffer *buffer,
         ipc::buffer::gb_err.err_msg << "failed to initialize index semaphore"; 
         shutdown_handler( 0 );
     }
+    /** what this thread can sit on has to scale with the buffer **/
+    ptr->magazine.set_limit( buffer->databuffer_size >> ipc::block_size_power_two );
 
     // tls is now allocated (and semaphores open), now register this thread in the index
     ptr->buffer         = buffer;
@@ -1468,10 +3113,12 @@ void
 ipc::buffer::close_tls_structure( ipc::thread_local_data* data )
 {
     ipc::buffer::unlink_channels( data );
+    ipc::buffer::flush_magazine( data );
+    data->stats.flush( data->buffer->stats );
     // Close semaphores
     ipc::sem::close( data->allocate_semaphore );
     ipc::sem::close( data->index_semaphore    );
     
-    ::free( data );
+    delete( data );
     return;
 }
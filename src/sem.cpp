@@ -227,6 +227,24 @@ ipc::sem::wait( ipc::sem::sem_obj_t obj )
 #endif
 }
 
+int 
+ipc::sem::try_wait( ipc::sem::sem_obj_t obj )
+{
+#if _USE_POSIX_SEM_ == 1
+    return( sem_trywait( obj ) );
+#elif _USE_SYSTEMV_SEM_ == 1
+    struct sembuf sops;
+    sops.sem_num = 0;
+    sops.sem_flg = IPC_NOWAIT;
+    sops.sem_op  = -1;
+    return( semop( obj, &sops, 1 ) );
+#else
+    UNUSED( obj );
+    //unimplemented
+    return( -1 );
+#endif
+}
+
 int 
 ipc::sem::post( ipc::sem::sem_obj_t key )
 {
@@ -20,6 +20,48 @@
 #include "translate.hpp"
 #include "bufferdefs.hpp"
 #include <cassert>
+#include <atomic>
+#include <mutex>
+
+namespace
+{
+
+/**
+ * extent_table - one per buffer registered in this process. Lookups
+ * are lock free, only registering and mapping a new extent take the
+ * table lock.
+ */
+struct extent_table
+{
+    std::atomic< void* >                        base        = { nullptr };
+    std::size_t                                 size        = 0;
+    ipc::translate_helper::extent_resolver_t    resolver    = nullptr;
+    void                                        *ctx        = nullptr;
+    std::atomic< void* >                        extent[ ipc::max_extents ];
+};
+
+constexpr std::size_t               max_registered  = 16;
+extent_table                        tables[ max_registered ];
+std::mutex                          table_lock;
+/** 
+ * count of extents mapped in this process over all buffers, while
+ * it's zero every offset is within extent zero and we skip the table.
+ */
+std::atomic< std::uint32_t >        mapped_extents  = { 0 };
+
+extent_table* find_table( const void * const base )
+{
+    for( auto &t : tables )
+    {
+        if( t.base.load( std::memory_order_acquire ) == base )
+        {
+            return( &t );
+        }
+    }
+    return( nullptr );
+}
+
+} /** end anonymous namespace **/
 
 void*
 ipc::translate_helper::translate( void        *base,
@@ -31,9 +73,29 @@ ipc::translate_helper::translate( void        *base,
     }
     /** some simple sanity checks **/
     const ipc::ptr_t safe_offset_start = 0;
-    const ipc::ptr_t safe_offset_end   = (1 << ipc::buffer_size_pow_two);
+    const ipc::ptr_t safe_offset_end   = ( ipc::ptr_t( 1 ) << ipc::max_buffer_size_pow_two );
 
-    if( offset < safe_offset_start || offset > safe_offset_end )
+    if( offset < safe_offset_start )
+    {
+        return( nullptr );
+    }
+    const auto extent = ( offset >> ipc::extent_offset_shift );
+    if( extent != 0 )
+    {
+        if( extent >= ipc::max_extents )
+        {
+            return( nullptr );
+        }
+        auto *extent_base = 
+            ipc::translate_helper::get_extent( base, (std::uint8_t) extent );
+        if( extent_base == nullptr )
+        {
+            return( nullptr );
+        }
+        return( (void*)( ( offset & ipc::extent_offset_mask ) + 
+                         (std::uintptr_t) extent_base ) );
+    }
+    if( offset > safe_offset_end )
     {
         return( nullptr );
     }
@@ -60,13 +122,44 @@ ipc::translate_helper::calculate_buffer_offset(  const void * const buffer_base,
         return( ipc::invalid_ptr_offset );
     }
 
-    //sanity check, let's see where the data buffer should be
-    const ipc::ptr_t safe_offset_start = 0;
-    const ipc::ptr_t safe_offset_end   = (1 << ipc::buffer_size_pow_two);
-    
     /** calculate offset **/
     const auto int_ptr_address = (std::uintptr_t)(address);
     const auto int_ptr_head    = (std::uintptr_t)(buffer_base);
+    
+    /**
+     * if this process has extents mapped, the address could be in 
+     * one of them, otherwise go by the plain checks below.
+     */
+    if( mapped_extents.load( std::memory_order_relaxed ) != 0 )
+    {
+        auto *table = find_table( buffer_base );
+        if( table != nullptr )
+        {
+            if( int_ptr_address >= int_ptr_head && 
+                int_ptr_address - int_ptr_head <= table->size )
+            {
+                return( int_ptr_address - int_ptr_head );
+            }
+            for( std::uint8_t e( 1 ); e < ipc::max_extents; e++ )
+            {
+                const auto extent_head = (std::uintptr_t) 
+                    table->extent[ e ].load( std::memory_order_acquire );
+                if( extent_head != 0 && 
+                    int_ptr_address >= extent_head &&
+                    int_ptr_address - extent_head <= table->size )
+                {
+                    return( ( ipc::ptr_t( e ) << ipc::extent_offset_shift ) | 
+                            ( int_ptr_address - extent_head ) );
+                }
+            }
+            return( ipc::invalid_ptr_offset );
+        }
+    }
+
+    //sanity check, let's see where the data buffer should be
+    const ipc::ptr_t safe_offset_start = 0;
+    const ipc::ptr_t safe_offset_end   = ( ipc::ptr_t( 1 ) << ipc::max_buffer_size_pow_two );
+    
     const auto offset = (int_ptr_address - int_ptr_head);
 
     /**
@@ -98,9 +191,93 @@ ipc::ptr_offset_t
 ipc::translate_helper::calculate_block_offset( const void * const buffer_base,
                                                const void * const address )
 {
+    if( mapped_extents.load( std::memory_order_relaxed ) != 0 )
+    {
+        const auto offset = 
+            ipc::translate_helper::calculate_buffer_offset( buffer_base, address );
+        assert( offset >= 0 );
+        return( offset >> ipc::block_size_power_two );
+    }
     const auto address_int = (std::uintptr_t) address;
     const auto buffer_int  = (std::uintptr_t) buffer_base;
     assert( address_int >= buffer_int );
     const auto diff        = address_int - buffer_int;
     return( (ipc::ptr_offset_t) ( diff / (1 << ipc::block_size_power_two ) ) );
 }
+
+bool
+ipc::translate_helper::register_buffer( void                    *base,
+                                        const std::size_t       size,
+                                        extent_resolver_t       resolver,
+                                        void                    *ctx )
+{
+    std::lock_guard< std::mutex > lock( table_lock );
+    if( find_table( base ) != nullptr )
+    {
+        return( true );
+    }
+    auto *table = find_table( nullptr );
+    if( table == nullptr )
+    {
+        return( false );
+    }
+    table->size     = size;
+    table->resolver = resolver;
+    table->ctx      = ctx;
+    table->extent[ 0 ].store( base, std::memory_order_relaxed );
+    for( std::uint8_t e( 1 ); e < ipc::max_extents; e++ )
+    {
+        table->extent[ e ].store( nullptr, std::memory_order_relaxed );
+    }
+    table->base.store( base, std::memory_order_release );
+    return( true );
+}
+
+void
+ipc::translate_helper::unregister_buffer( void *base )
+{
+    std::lock_guard< std::mutex > lock( table_lock );
+    auto *table = find_table( base );
+    if( table == nullptr )
+    {
+        return;
+    }
+    for( std::uint8_t e( 1 ); e < ipc::max_extents; e++ )
+    {
+        if( table->extent[ e ].exchange( nullptr, std::memory_order_acq_rel ) != nullptr )
+        {
+            mapped_extents.fetch_sub( 1, std::memory_order_relaxed );
+        }
+    }
+    table->base.store( nullptr, std::memory_order_release );
+}
+
+void*
+ipc::translate_helper::get_extent( void                 *base,
+                                   const std::uint8_t   extent,
+                                   const bool           map )
+{
+    auto *table = find_table( base );
+    if( table == nullptr || extent >= ipc::max_extents )
+    {
+        return( extent == 0 ? base : nullptr );
+    }
+    auto *extent_base = table->extent[ extent ].load( std::memory_order_acquire );
+    if( extent_base != nullptr || ! map )
+    {
+        return( extent_base );
+    }
+    /** first time this process has seen it, map it in **/
+    std::lock_guard< std::mutex > lock( table_lock );
+    extent_base = table->extent[ extent ].load( std::memory_order_acquire );
+    if( extent_base == nullptr )
+    {
+        extent_base = table->resolver( table->ctx, extent );
+        if( extent_base != nullptr )
+        {
+            table->extent[ extent ].store( extent_base, std::memory_order_release );
+            mapped_extents.fetch_add( 1, std::memory_order_relaxed );
+        }
+    }
+    return( extent_base );
+}
@@ -0,0 +1,170 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 15:21:09 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 48 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    ipc::alloc_stats_snapshot before;
+    ipc::buffer::get_stats( tls, before );
+    if( before.total_bytes != ( buffer->databuffer_size ) )
+    {
+        FAIL( "total bytes " << before.total_bytes << " expected " << buffer->databuffer_size );
+    }
+
+    /** 1MiB + header is too big for the magazine, frees go to the heap **/
+    const auto nbytes = ( 1 << 20 );
+    const auto count  = 16;
+    std::vector< void* > records;
+    for( auto i( 0 ); i < count; i++ )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate record " << i );
+        }
+        records.push_back( ptr );
+    }
+    const auto bucket =
+        ipc::alloc_stats::size_bucket( ipc::buffer::get_record_size( tls, records[ 0 ] ) );
+
+    ipc::alloc_stats_snapshot allocated;
+    ipc::buffer::get_stats( tls, allocated );
+    if( allocated.allocs[ bucket ] - before.allocs[ bucket ] != count )
+    {
+        FAIL( "allocs in bucket " << bucket << ": " <<
+            ( allocated.allocs[ bucket ] - before.allocs[ bucket ] ) << " expected " << count );
+    }
+    const auto heap_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap ) << buffer->block_size_pow_two;
+    if( allocated.free_bytes != heap_free )
+    {
+        FAIL( "free bytes " << allocated.free_bytes << " heap says " << heap_free );
+    }
+    if( allocated.largest_free_run > allocated.free_bytes )
+    {
+        FAIL( "largest free run bigger than the free space" );
+    }
+
+    /** free every other one, leaves holes the size of a record **/
+    for( auto i( 0 ); i < count; i += 2 )
+    {
+        ipc::buffer::free_record( tls, records[ i ] );
+    }
+    ipc::alloc_stats_snapshot holes;
+    ipc::buffer::get_stats( tls, holes );
+    if( holes.frees[ bucket ] - allocated.frees[ bucket ] != ( count / 2 ) )
+    {
+        FAIL( "frees in bucket " << bucket << ": " <<
+            ( holes.frees[ bucket ] - allocated.frees[ bucket ] ) << " expected " << ( count / 2 ) );
+    }
+    const auto hole_bucket = ipc::alloc_stats::run_bucket( nbytes );
+    std::uint64_t runs = 0;
+    for( std::size_t b( 0 ); b < ipc::alloc_stats::run_buckets; b++ )
+    {
+        runs += holes.free_runs[ b ];
+    }
+    if( runs < ( count / 2 ) || holes.free_runs[ hole_bucket ] < ( ( count / 2 ) - 1 ) )
+    {
+        FAIL( "expected a free run per hole, got " << runs << " runs, " <<
+            holes.free_runs[ hole_bucket ] << " in bucket " << hole_bucket );
+    }
+    if( holes.fragmentation() <= allocated.fragmentation() )
+    {
+        FAIL( "fragmentation didn't go up: " << holes.fragmentation() );
+    }
+
+    /** can't ever fit, no extents by default **/
+    if( ipc::buffer::allocate_record( tls, buffer->databuffer_size, channel_id ) != nullptr )
+    {
+        FAIL( "oversize record allocated" );
+    }
+    ipc::alloc_stats_snapshot failed;
+    ipc::buffer::get_stats( tls, failed );
+    if( failed.failures != ( holes.failures + 1 ) )
+    {
+        FAIL( "failure not counted" );
+    }
+    if constexpr( ! ipc::meta_info::heap_t::is_lock_free )
+    {
+        /** one thread, the semaphore was always free **/
+        if( failed.sem_waits != 0 )
+        {
+            FAIL( "uncontended alloc semaphore waits counted" );
+        }
+        /** 
+         * hold the alloc semaphore while another thread needs the heap,
+         * bigger than a heap leaf so it can't come from the local run.
+         */
+        const auto hold = std::chrono::milliseconds( 20 );
+        ipc::sem::wait( tls->allocate_semaphore );
+        void *big = nullptr;
+        std::thread waiter( [&](){
+            big = ipc::buffer::allocate_record( tls, ( 4 << 20 ), channel_id );
+        } );
+        std::this_thread::sleep_for( hold );
+        ipc::sem::post( tls->allocate_semaphore );
+        waiter.join();
+        if( big == nullptr )
+        {
+            FAIL( "allocation behind the held semaphore failed" );
+        }
+        ipc::buffer::free_record( tls, big );
+        ipc::alloc_stats_snapshot contended;
+        ipc::buffer::get_stats( tls, contended );
+        if( contended.sem_waits == 0 || 
+            contended.sem_wait_ns < std::uint64_t( 
+                std::chrono::duration_cast< std::chrono::nanoseconds >( hold ).count() / 2 ) )
+        {
+            FAIL( "contended wait not counted, " << contended.sem_waits << 
+                  " waits " << contended.sem_wait_ns << "ns" );
+        }
+    }
+
+    for( auto i( 1 ); i < count; i += 2 )
+    {
+        ipc::buffer::free_record( tls, records[ i ] );
+    }
+    ipc::buffer::close_tls_structure( tls );
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
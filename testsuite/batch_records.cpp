@@ -0,0 +1,197 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 20:11:06 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; exit( EXIT_FAILURE ); }
+
+using gate_t = std::atomic< int >;
+
+/** 64B telemetry events, sent batch at a time **/
+static constexpr std::size_t    event_bytes = 64;
+static constexpr std::size_t    batch       = 32;
+
+void producer(  const std::uint64_t count,
+                const ipc::channel_id_t channel_id,
+                ipc::buffer *buffer,
+                gate_t &g )
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "producer failed to add channel" );
+    }
+    g++;
+    while( g != 2 ){ __asm__ volatile ( "nop" : : : ); }
+
+    void *records[ batch ];
+    std::uint64_t next = 0;
+    while( next < count )
+    {
+        const auto n = std::min< std::uint64_t >( batch, count - next );
+        for( std::size_t i( 0 ); i < n; i++ )
+        {
+            auto *event = (std::uint64_t*)
+                ipc::buffer::allocate_record( tls, event_bytes, channel_id );
+            if( event == nullptr )
+            {
+                FAIL( "failed to allocate" );
+            }
+            *event = next + i;
+            records[ i ] = event;
+        }
+        std::size_t done = 0;
+        while( done < n )
+        {
+            std::size_t sent = 0;
+            ipc::buffer::send_records( tls, channel_id, &records[ done ], n - done, sent );
+            done += sent;
+        }
+        next += n;
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+}
+
+void consumer(  const std::uint64_t count,
+                const ipc::channel_id_t channel_id,
+                ipc::buffer *buffer,
+                gate_t &g )
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::consumer ) == ipc::channel_err )
+    {
+        FAIL( "consumer failed to add channel" );
+    }
+    g++;
+    while( g != 2 ){ __asm__ volatile ( "nop" : : : ); }
+
+    /** odd sized so receives straddle the producer's batches **/
+    void *records[ batch - 5 ];
+    std::uint64_t expected = 0;
+    while( expected < count )
+    {
+        std::size_t received = 0;
+        if( ipc::buffer::receive_records( tls, channel_id, records, batch - 5, received ) != ipc::tx_success )
+        {
+            continue;
+        }
+        for( std::size_t i( 0 ); i < received; i++ )
+        {
+            if( *(std::uint64_t*) records[ i ] != expected )
+            {
+                FAIL( "out of order, got " << *(std::uint64_t*) records[ i ] <<
+                      " expected " << expected );
+            }
+            expected++;
+        }
+        ipc::buffer::free_records( tls, records, received );
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 51 );
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    /** single thread first, a batch bigger than the ring only partly goes **/
+    {
+        const auto channel_id = 1;
+        auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+        if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+        {
+            FAIL( "failed to add channel" );
+        }
+        const auto ring = ipc::ch_entries_spsc::n_entries;
+        std::vector< void* > records;
+        for( std::size_t i( 0 ); i < ring + 10; i++ )
+        {
+            auto *event = (std::uint64_t*) ipc::buffer::allocate_record( tls, event_bytes, channel_id );
+            *event = i;
+            records.push_back( event );
+        }
+        std::size_t sent = 0;
+        if( ipc::buffer::send_records( tls, channel_id, records.data(), records.size(), sent ) != ipc::tx_success ||
+            sent != ring )
+        {
+            FAIL( "expected to fill the ring, sent " << sent );
+        }
+        std::size_t more = 0;
+        if( ipc::buffer::send_records( tls, channel_id, &records[ sent ], 10, more ) != ipc::tx_retry || more != 0 )
+        {
+            FAIL( "sent into a full ring" );
+        }
+        std::vector< void* > out( ring + 10, nullptr );
+        std::size_t received = 0;
+        if( ipc::buffer::receive_records( tls, channel_id, out.data(), out.size(), received ) != ipc::tx_success ||
+            received != ring )
+        {
+            FAIL( "expected to drain the ring, got " << received );
+        }
+        for( std::size_t i( 0 ); i < received; i++ )
+        {
+            if( out[ i ] != records[ i ] )
+            {
+                FAIL( "record " << i << " out of order" );
+            }
+        }
+        /** the rest go now, and wrap **/
+        if( ipc::buffer::send_records( tls, channel_id, &records[ sent ], 10, more ) != ipc::tx_success || more != 10 )
+        {
+            FAIL( "failed to send after drain" );
+        }
+        if( ipc::buffer::receive_records( tls, channel_id, out.data(), out.size(), received ) != ipc::tx_success ||
+            received != 10 || out[ 9 ] != records.back() )
+        {
+            FAIL( "failed to receive across the wrap" );
+        }
+        if( ipc::buffer::receive_records( tls, channel_id, out.data(), out.size(), received ) != ipc::tx_retry ||
+            received != 0 )
+        {
+            FAIL( "received from an empty ring" );
+        }
+        ipc::buffer::free_records( tls, records.data(), records.size() );
+        ipc::buffer::unlink_channels( tls );
+        ipc::buffer::close_tls_structure( tls );
+    }
+
+    const auto channel_id = 2;
+    gate_t gate = {0};
+    const std::uint64_t count = ( 1 << 18 );
+    std::thread source( producer, count, channel_id, buffer, std::ref( gate ) );
+    std::thread dest  ( consumer, count, channel_id, buffer, std::ref( gate ) );
+    source.join();
+    dest.join();
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,123 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 15:02:37 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 44 );
+
+    /** block bigger than the buffer, shouldn't get anything back **/
+    ipc::buffer_config bad;
+    bad.buffer_size_pow_two = ipc::min_buffer_size_pow_two;
+    bad.block_size_pow_two  = ipc::max_block_size_pow_two + 1;
+    if( ipc::buffer::initialize( key, bad ) != nullptr )
+    {
+        std::cerr << "invalid config accepted\n";
+        exit( EXIT_FAILURE );
+    }
+
+    /** 64MiB buffer with 64KiB allocation blocks **/
+    ipc::buffer_config config;
+    config.buffer_size_pow_two = 26;
+    config.block_size_pow_two  = 16;
+    auto *buffer = ipc::buffer::initialize( key, config );
+    if( buffer == nullptr )
+    {
+        std::cerr << "failed to initialize 64MiB buffer\n";
+        exit( EXIT_FAILURE );
+    }
+
+    /** somebody attaching with a different config gets ours **/
+    auto *attached = ipc::buffer::initialize( key );
+    const auto attached_config = ipc::buffer::get_config( attached );
+    if( attached_config.buffer_size_pow_two != 26 || 
+        attached_config.block_size_pow_two  != 16 )
+    {
+        FAIL( "attached buffer doesn't have the creator's geometry" );
+    }
+    ipc::buffer::destruct( attached, key, false /** unlink **/ );
+
+    const std::size_t heap_blocks = ( 1 << ( 26 - 16 ) );
+    if( ipc::meta_info::heap_t::get_total_blocks( &buffer->heap ) != heap_blocks ||
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap ) != heap_blocks )
+    {
+        FAIL( "heap not sized for the buffer" );
+    }
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /** 
+     * 100KiB records, every record plus its header should take 
+     * two allocation blocks, keep going till we run out, we should 
+     * never get more than the buffer holds.
+     */
+    const std::size_t record_bytes = 100 << 10;
+    std::vector< std::uint8_t* > records;
+    while( true )
+    {
+        auto *ptr = (std::uint8_t*) 
+            ipc::buffer::allocate_record( tls, record_bytes, channel_id );
+        if( ptr == nullptr )
+        {
+            break;
+        }
+        const auto offset = ipc::buffer::calculate_buffer_offset( &buffer->data, ptr );
+        if( ( ( offset - ipc::inline_header::header_size ) & ( ( 1 << 16 ) - 1 ) ) != 0 )
+        {
+            FAIL( "record header not aligned to an allocation block" );
+        }
+        std::memset( ptr, 0xff, record_bytes );
+        records.push_back( ptr );
+    }
+    if( records.empty() || records.size() * ( 2 << 16 ) > ( 1 << 26 ) )
+    {
+        FAIL( "allocated " << records.size() << " records from a 64MiB buffer" );
+    }
+    for( auto *ptr : records )
+    {
+        ipc::buffer::free_record( tls, ptr );
+    }
+    ipc::buffer::close_tls_structure( tls );
+
+    if( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) != heap_blocks )
+    {
+        FAIL( "leaked blocks, ended with " << 
+            ipc::meta_info::heap_t::get_current_free( &buffer->heap ) );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
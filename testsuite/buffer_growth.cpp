@@ -0,0 +1,140 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 16:48:19 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <buffer>
+
+/** 
+ * 16MiB buffer that may grow by two extents, the producer holds on 
+ * to 16MiB of records (plus meta blocks) before sending any so the 
+ * buffer has to grow, 
+ * the consumer (another process) has to map the extents itself.
+ */
+static constexpr int            count           = 64;
+static constexpr std::size_t    record_bytes    = ( 1 << 18 );
+
+static bool producer( const ipc::channel_id_t channel_id, ipc::buffer *buffer ) 
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        return( false );
+    }
+    std::vector< std::uint8_t* > records;
+    bool in_extent = false;
+    for( int i( 0 ); i < count; i++ )
+    {
+        auto *ptr = (std::uint8_t*) 
+            ipc::buffer::allocate_record( tls, record_bytes, channel_id );
+        if( ptr == nullptr )
+        {
+            std::cerr << "allocation " << i << " failed, buffer didn't grow\n";
+            return( false );
+        }
+        std::memset( ptr, i, record_bytes );
+        const auto offset = ipc::buffer::calculate_buffer_offset( &buffer->data, ptr );
+        if( offset < 0 || ipc::buffer::translate( &buffer->data, offset ) != ptr )
+        {
+            std::cerr << "offset for record " << i << " doesn't translate back\n";
+            return( false );
+        }
+        in_extent |= ( ( offset >> ipc::extent_offset_shift ) != 0 );
+        records.push_back( ptr );
+    }
+    if( ! in_extent || buffer->extent_count.load() < 2 )
+    {
+        std::cerr << "no records came from an extent\n";
+        return( false );
+    }
+    for( auto *ptr : records )
+    {
+        while( ipc::buffer::send_record( tls, channel_id, (void**)&ptr ) != ipc::tx_success );
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+    return( true );
+}
+
+static bool consumer( const ipc::channel_id_t channel_id, ipc::buffer *buffer ) 
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::consumer ) == ipc::channel_err )
+    {
+        return( false );
+    }
+    for( int i( 0 ); i < count; i++ )
+    {
+        void *record = nullptr;
+        while( ipc::buffer::receive_record( tls, channel_id, &record ) != ipc::tx_success );
+        const auto *bytes = (std::uint8_t*) record;
+        if( bytes[ 0 ] != ( i & 0xff ) || bytes[ record_bytes - 1 ] != ( i & 0xff ) )
+        {
+            std::cerr << "record " << i << " has the wrong contents\n";
+            return( false );
+        }
+        ipc::buffer::free_record( tls, record );
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+    return( true );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    const auto channel_id = 1;
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 45 );
+
+    ipc::buffer_config config;
+    config.buffer_size_pow_two  = ipc::min_buffer_size_pow_two;
+    config.growth_extents       = 2;
+
+    const auto child = fork();
+    if( child == -1 )
+    {
+        exit( EXIT_FAILURE );
+    }
+    auto *buffer = ipc::buffer::initialize( key, config );
+    if( child != 0 )
+    {
+        const auto ok = producer( channel_id, buffer );
+        if( ! ok )
+        {
+            /** consumer would wait forever **/
+            kill( child, SIGTERM );
+        }
+        int status = 0;
+        waitpid( child, &status, 0 );
+        ipc::buffer::destruct( buffer, key );
+        return( ok && WIFEXITED( status ) && WEXITSTATUS( status ) == EXIT_SUCCESS ? 
+                EXIT_SUCCESS : EXIT_FAILURE );
+    }
+    const auto ok = consumer( channel_id, buffer );
+    ipc::buffer::destruct( buffer, key, false );
+    return( ok ? EXIT_SUCCESS : EXIT_FAILURE );
+}
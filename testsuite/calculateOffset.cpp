@@ -17,7 +17,8 @@ int main()
     const auto offset1 = ipc::buffer::calculate_buffer_offset( base, (void*)(base));
     const auto offset3 = ipc::buffer::calculate_buffer_offset( base, (void*)(base-1));
     const auto offset5 = ipc::buffer::calculate_buffer_offset( base, (void*)(0));
-    const auto offset6 = ipc::buffer::calculate_buffer_offset( base, (void*)(base + ( 1<<ipc::buffer_size_pow_two )+1 ) );
+    /** buffer size is runtime now, sanity check is against the largest one **/
+    const auto offset6 = ipc::buffer::calculate_buffer_offset( base, (void*)(base + ( std::size_t( 1 )<<ipc::max_buffer_size_pow_two )+1 ) );
 
 
     /** Offsets should be zero */
@@ -60,14 +60,14 @@ int main()
         std::cout << "offset should be (0), but it is (" << diff << ")\n";
         return( EXIT_FAILURE );
     }
-    if( (diff = convert( &ch_ptr->ctrl_all, buffer  ) ) != (L1D_CACHE_LINE_SIZE * 4) ) 
+    if( (diff = convert( &ch_ptr->ctrl_all, buffer  ) ) != (L1D_CACHE_LINE_SIZE * 2) ) 
     {
-        std::cout << "offset should be (256), but it is (" << diff << ")\n";
+        std::cout << "offset should be (128), but it is (" << diff << ")\n";
         return( EXIT_FAILURE );
     }
-    if( (diff = convert( &ch_ptr->ctrl_spsc, buffer ) ) != (L1D_CACHE_LINE_SIZE*6) ) 
+    if( (diff = convert( &ch_ptr->ctrl_spsc, buffer ) ) != (L1D_CACHE_LINE_SIZE*4) ) 
     {
-        std::cout << "offset should be (384), but it is (" << diff << ")\n";
+        std::cout << "offset should be (256), but it is (" << diff << ")\n";
         return( EXIT_FAILURE );
     }
     //this one should hit block boundary, otherwise we've broken something
@@ -0,0 +1,127 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 16:58:03 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    /** merge check first, doesn't need the buffer **/
+    std::vector< ipc::block_run_t > runs = { { 10, 2 }, { 0, 4 }, { 4, 6 }, { 12, 1 }, { 20, 1 } };
+    ipc::deferred_free::coalesce( runs );
+    if( runs.size() != 2 || runs[ 0 ] != ipc::block_run_t( 0, 13 ) || 
+        runs[ 1 ] != ipc::block_run_t( 20, 1 ) )
+    {
+        FAIL( "adjacent runs not coalesced" );
+    }
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /** 1MiB + header is too big for the magazine **/
+    const auto nbytes = ( 1 << 20 );
+    std::vector< void* > records;
+    for( auto i( 0 ); i < 8; i++ )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate record " << i );
+        }
+        records.push_back( ptr );
+    }
+    const auto current_free = [&](){ 
+        return( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) ); 
+    };
+
+    /** count bound, nothing goes back until the 4th **/
+    ipc::buffer::set_deferred_free( tls, 4, std::chrono::seconds( 10 ) );
+    const auto held = current_free();
+    for( auto i( 0 ); i < 3; i++ )
+    {
+        ipc::buffer::free_record( tls, records[ i ] );
+    }
+    if( current_free() != held || tls->deferred.runs.size() != 3 )
+    {
+        FAIL( "runs should be held on the deferred list" );
+    }
+    ipc::buffer::free_record( tls, records[ 3 ] );
+    if( current_free() <= held || ! tls->deferred.runs.empty() )
+    {
+        FAIL( "deferred list not flushed at max_records" );
+    }
+
+    /** age bound **/
+    ipc::buffer::set_deferred_free( tls, 100, std::chrono::milliseconds( 1 ) );
+    auto before = current_free();
+    ipc::buffer::free_record( tls, records[ 4 ] );
+    if( current_free() != before )
+    {
+        FAIL( "run should be held on the deferred list" );
+    }
+    std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+    ipc::buffer::free_record( tls, records[ 5 ] );
+    if( current_free() <= before || ! tls->deferred.runs.empty() )
+    {
+        FAIL( "deferred list not flushed after max_age" );
+    }
+
+    /** batch with deferral off goes straight back **/
+    ipc::buffer::set_deferred_free( tls, 0, std::chrono::microseconds( 0 ) );
+    before = current_free();
+    ipc::buffer::free_records( tls, &records[ 6 ], 2 );
+    if( current_free() <= before || ! tls->deferred.runs.empty() )
+    {
+        FAIL( "batch free didn't return the runs" );
+    }
+
+    ipc::buffer::close_tls_structure( tls );
+
+    const auto final_free = current_free();
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,121 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 19:40:22 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+/**
+ * touch random records, this is where huge pages should help, 
+ * timing is printed not checked given THP may not be on for shared
+ * memory wherever this runs.
+ */
+static double random_touch( ipc::buffer *buffer, std::uint8_t **records, const std::size_t count )
+{
+    std::uint64_t x = 0x9e3779b97f4a7c15;
+    std::uint64_t sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for( auto i( 0 ); i < ( 1 << 22 ); i++ )
+    {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        sum += records[ x % count ][ ( x >> 32 ) & 0xfff ]++;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    UNUSED( buffer );
+    __asm__ volatile( "" : : "r"( sum ) : );
+    return( std::chrono::duration< double, std::milli >( end - start ).count() );
+}
+
+static bool run( const ipc::page_mode mode, double &ms )
+{
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 46 );
+
+    ipc::buffer_config config;
+    config.buffer_size_pow_two  = 28;
+    config.pages                = mode;
+    auto *buffer = ipc::buffer::initialize( key, config );
+    if( buffer == nullptr )
+    {
+        std::cerr << "failed to initialize buffer\n";
+        return( false );
+    }
+    
+    /** attaching side gets the creator's mode **/
+    auto *attached = ipc::buffer::initialize( key );
+    if( ipc::buffer::get_config( attached ).pages != mode )
+    {
+        std::cerr << "attached buffer doesn't have the creator's page mode\n";
+        ipc::buffer::destruct( buffer, key );
+        return( false );
+    }
+    ipc::buffer::destruct( attached, key, false /** unlink **/ );
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        std::cerr << "failed to add channel\n";
+        ipc::buffer::destruct( buffer, key );
+        return( false );
+    }
+    /** fill half the buffer with 1MiB records **/
+    std::vector< std::uint8_t* > records;
+    for( auto i( 0 ); i < 128; i++ )
+    {
+        auto *ptr = (std::uint8_t*) ipc::buffer::allocate_record( tls, 1 << 20, channel_id );
+        if( ptr == nullptr )
+        {
+            std::cerr << "failed to allocate record " << i << "\n";
+            ipc::buffer::destruct( buffer, key );
+            return( false );
+        }
+        std::memset( ptr, i, 1 << 20 );
+        records.push_back( ptr );
+    }
+    ms = random_touch( buffer, records.data(), records.size() );
+    for( auto *ptr : records )
+    {
+        ipc::buffer::free_record( tls, ptr );
+    }
+    ipc::buffer::close_tls_structure( tls );
+    ipc::buffer::destruct( buffer, key );
+    return( true );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    double base_ms = 0.0;
+    double huge_ms = 0.0;
+    if( ! run( ipc::page_default, base_ms ) || ! run( ipc::page_huge, huge_ms ) )
+    {
+        exit( EXIT_FAILURE );
+    }
+    std::cout << "random touch, base pages: " << base_ms << "ms, huge pages: " << huge_ms << "ms\n";
+    return( EXIT_SUCCESS );
+}
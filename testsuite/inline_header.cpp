@@ -0,0 +1,108 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 16:12:40 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /**
+     * 3000B records are too big for the slab but with the header 
+     * inline they still fit in a single block each, with a separate
+     * metadata block they'd take two.
+     */
+    const auto nbytes = 3000;
+    const auto block_size = ( 1 << ipc::block_size_power_two );
+    std::vector< std::uint8_t* > records;
+    for( auto i( 0 ); i < 4; i++ )
+    {
+        auto *ptr = (std::uint8_t*) ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate record " << i );
+        }
+        const auto offset = ipc::buffer::calculate_buffer_offset( &tls->buffer->data, ptr );
+        if( ( offset & ( block_size - 1 ) ) != ipc::inline_header::header_size )
+        {
+            FAIL( "record should start right after its header, offset " << offset );
+        }
+        if( ipc::buffer::get_record_size( tls, ptr ) != 
+                ( block_size - ipc::inline_header::header_size ) )
+        {
+            FAIL( "wrong record size, got " << ipc::buffer::get_record_size( tls, ptr ) );
+        }
+        if( ! records.empty() && ( ptr - records.back() ) != block_size )
+        {
+            FAIL( "records should be one block apart" );
+        }
+        std::memset( ptr, i, nbytes );
+        records.push_back( ptr );
+    }
+    for( std::size_t i( 0 ); i < records.size(); i++ )
+    {
+        for( auto j( 0 ); j < nbytes; j++ )
+        {
+            if( records[ i ][ j ] != i )
+            {
+                FAIL( "record " << i << " overwritten" );
+            }
+        }
+    }
+
+    for( auto *ptr : records )
+    {
+        ipc::buffer::free_record( tls, ptr );
+    }
+    ipc::buffer::close_tls_structure( tls );
+
+    const auto final_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,117 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 14:20:41 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 43 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto record_channel  = 1;
+    const auto segment_channel = 2;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &tls->buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, record_channel, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /** 16MiB, eight heap leaves worth of blocks **/
+    const std::size_t record_bytes = ( 1 << 24 );
+    auto *record = (std::uint8_t*) ipc::buffer::allocate_record( tls, record_bytes, record_channel );
+    if( record == nullptr )
+    {
+        FAIL( "failed to allocate 16MiB record" );
+    }
+    if( ipc::buffer::get_record_size( tls, record ) < record_bytes )
+    {
+        FAIL( "wrong record size, got " << ipc::buffer::get_record_size( tls, record ) );
+    }
+    std::memset( record, 0xab, record_bytes );
+
+    /** a shared segment bigger than a leaf goes down the same path **/
+    const std::size_t segment_bytes = ( 1 << 23 ) + 4096;
+    if( ipc::buffer::add_shared_segment( tls, segment_channel, segment_bytes ) == ipc::channel_err )
+    {
+        FAIL( "failed to add 8MiB shared segment" );
+    }
+    std::uint8_t *segment = nullptr;
+    if( ipc::buffer::open_shared_segment( tls, segment_channel, (void**)&segment ) != ipc::tx_success )
+    {
+        FAIL( "failed to open shared segment" );
+    }
+    std::memset( segment, 0xcd, segment_bytes );
+
+    for( std::size_t i( 0 ); i < record_bytes; i++ )
+    {
+        if( record[ i ] != 0xab )
+        {
+            FAIL( "record overwritten at byte " << i );
+        }
+    }
+
+    ipc::buffer::free_record( tls, record );
+    /** should be able to get the same span back out **/
+    record = (std::uint8_t*) ipc::buffer::allocate_record( tls, record_bytes, record_channel );
+    if( record == nullptr )
+    {
+        FAIL( "failed to re-allocate 16MiB record" );
+    }
+    ipc::buffer::free_record( tls, record );
+
+    /**
+     * the freed span is too big for the magazine, so it's already back
+     * in the heap, only the channels and the segment should be held.
+     */
+    const auto used_blocks = initial_free -
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    const auto segment_blocks =
+        ipc::meta_info::heap_t::get_block_multiple( segment_bytes );
+    if( used_blocks < segment_blocks || used_blocks >= segment_blocks + 512 )
+    {
+        FAIL( "unexpected block usage after free: " << used_blocks );
+    }
+
+    ipc::buffer::close_tls_structure( tls );
+
+    const auto final_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
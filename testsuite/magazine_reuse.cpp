@@ -0,0 +1,180 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 11:41:09 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    /** 1GiB default buffer, full size magazine **/
+    if( tls->magazine.high_water_blocks != ipc::block_magazine::default_high_water_blocks )
+    {
+        FAIL( "magazine limit " << tls->magazine.high_water_blocks << " for the default buffer" );
+    }
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /** 8KiB record, the header pushes it into a third block **/
+    const auto nbytes = ( 2 << ipc::block_size_power_two );
+    auto *first = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+    if( first == nullptr )
+    {
+        FAIL( "failed to allocate" );
+    }
+    const auto after_alloc = 
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    ipc::buffer::free_record( tls, first );
+    /** should be sitting in the magazine, not the heap **/
+    if( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) != after_alloc )
+    {
+        FAIL( "free went to the heap, expected it in the magazine" );
+    }
+    
+    auto *second = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+    if( second != first || ipc::buffer::get_record_size( tls, second ) < nbytes )
+    {
+        FAIL( "expected the magazine run to be reused" );
+    }
+
+    /**
+     * now allocate enough to go past the high water mark, once they're 
+     * all freed the magazine should have flushed back to the heap.
+     */
+    std::vector< void* > records;
+    const auto runs = ( tls->magazine.high_water_blocks / 3 ) + 1; 
+    for( std::size_t i( 0 ); i < runs; i++ )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate record " << i );
+        }
+        records.push_back( ptr );
+    }
+    const auto before_free = 
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    for( auto *ptr : records )
+    {
+        ipc::buffer::free_record( tls, ptr );
+    }
+    if( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) <= before_free )
+    {
+        FAIL( "magazine never flushed to the heap" );
+    }
+    if( tls->magazine.cached_blocks > tls->magazine.high_water_blocks )
+    {
+        FAIL( "magazine over high water mark" );
+    }
+
+    /**
+     * a thread that only frees (a consumer) hands its runs back once
+     * they've sat unused, even under the high water mark.
+     */
+    records.clear();
+    for( std::uint32_t i( 0 ); i < ( ipc::block_magazine::idle_check_interval * 2 ); i++ )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate record " << i );
+        }
+        records.push_back( ptr );
+    }
+    std::thread consumer( [&](){
+        auto *tls_cons = ipc::buffer::get_tls_structure( buffer, getpid() );
+        const auto half = ipc::block_magazine::idle_check_interval;
+        for( std::size_t i( 0 ); i < half; i++ )
+        {
+            ipc::buffer::free_record( tls_cons, records[ i ] );
+        }
+        if( tls_cons->magazine.empty() )
+        {
+            FAIL( "consumer magazine flushed before it went idle" );
+        }
+        const auto before_idle = 
+            ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+        std::this_thread::sleep_for( tls_cons->magazine.max_idle * 2 );
+        for( std::size_t i( half ); i < records.size(); i++ )
+        {
+            ipc::buffer::free_record( tls_cons, records[ i ] );
+        }
+        if( ! tls_cons->magazine.empty() || 
+            ipc::meta_info::heap_t::get_current_free( &buffer->heap ) <= before_idle )
+        {
+            FAIL( "idle magazine wasn't flushed, holding " << tls_cons->magazine.cached_blocks );
+        }
+        ipc::buffer::close_tls_structure( tls_cons );
+    } );
+    consumer.join();
+
+    ipc::buffer::free_record( tls, second );
+    ipc::buffer::close_tls_structure( tls );
+
+    /** a 16MiB buffer only lets a thread sit on a 64th of it **/
+    {
+        shm_key_t small_key;
+        ipc::buffer::gen_key( small_key, 55 );
+        ipc::buffer_config config;
+        config.buffer_size_pow_two = ipc::min_buffer_size_pow_two;
+        auto *small = ipc::buffer::initialize( small_key, config );
+        auto *small_tls = ipc::buffer::get_tls_structure( small, getpid() );
+        const auto limit = small_tls->magazine.high_water_blocks;
+        ipc::buffer::close_tls_structure( small_tls );
+        ipc::buffer::destruct( small, small_key );
+        if( limit != ( ( std::size_t( 1 ) << ( ipc::min_buffer_size_pow_two - 
+                                               ipc::block_size_power_two ) ) >> 6 ) )
+        {
+            FAIL( "magazine limit " << limit << " for a 16MiB buffer" );
+        }
+    }
+
+    const auto final_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
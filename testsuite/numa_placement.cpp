@@ -0,0 +1,158 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 09:14:36 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+/** node the page at ptr is on, -1 if we can't tell **/
+static int page_node( void *ptr )
+{
+#if _IPC_USE_NUMA_ == 1 && defined( SYS_move_pages )
+    void *pages[ 1 ]  = { ptr };
+    int   status[ 1 ] = { -1 };
+    if( syscall( SYS_move_pages, 0, 1, pages, nullptr, status, 0 ) != 0 )
+    {
+        return( -1 );
+    }
+    return( status[ 0 ] );
+#else
+    UNUSED( ptr );
+    return( -1 );
+#endif
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    auto *tls_prod = ipc::buffer::get_tls_structure( buffer, getpid() );
+    auto *tls_cons = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    /** producer creates it without a hint, consumer places it **/
+    const auto channel_id = 1;
+    if( ipc::buffer::add_spsc_lf_record_channel( tls_prod, channel_id, ipc::producer ) == ipc::channel_err ||
+        ipc::buffer::add_spsc_lf_record_channel( tls_cons, channel_id, ipc::consumer, 0, 0 ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+    auto *channel = tls_prod->channel_map[ channel_id ];
+    if( channel->meta.numa_node.load() != 0 )
+    {
+        FAIL( "consumer's hint not applied to an existing channel" );
+    }
+
+    /** records default to the channel's node **/
+    const auto nbytes = ( 1 << 16 );
+    auto *record = (std::uint8_t*) ipc::buffer::allocate_record( tls_prod, nbytes, channel_id );
+    if( record == nullptr )
+    {
+        FAIL( "failed to allocate" );
+    }
+    std::memset( record, 0xab, nbytes );
+    const auto node = page_node( record );
+    if( node != -1 && node != 0 )
+    {
+        FAIL( "record on node " << node << " not node 0" );
+    }
+    ipc::buffer::free_record( tls_prod, record );
+
+    /** a node that can't exist still gets memory, just unplaced **/
+    record = (std::uint8_t*) ipc::buffer::allocate_record( tls_prod, nbytes, channel_id, 1000 );
+    if( record == nullptr )
+    {
+        FAIL( "bad node hint should fall back" );
+    }
+    std::memset( record, 0xcd, nbytes );
+    ipc::buffer::free_record( tls_prod, record );
+
+#if _IPC_USE_NUMA_ == 1
+    /** 
+     * flipping between two hints parks each node's run (and slabs)
+     * instead of throwing it away, small records follow the hint too.
+     */
+    {
+        const std::size_t small = 64;
+        /** not a size the magazine has from above **/
+        const std::size_t big   = 3 * nbytes;
+        auto *small_0   = ipc::buffer::allocate_record( tls_prod, small, channel_id, 0 );
+        auto *big_0     = (std::uint8_t*) ipc::buffer::allocate_record( tls_prod, big, channel_id, 0 );
+        const auto big_0_bytes = ipc::buffer::get_record_size( tls_prod, big_0 );
+        auto *small_1   = ipc::buffer::allocate_record( tls_prod, small, channel_id, 1000 );
+        auto *big_1     = ipc::buffer::allocate_record( tls_prod, big, channel_id, 1000 );
+        auto &info      = tls_prod->channel_local_allocation[ channel_id ];
+        if( ! info.parked[ 0 ].valid || info.parked[ 0 ].node != 0 || info.run_node != 1000 )
+        {
+            FAIL( "node 0 run wasn't parked" );
+        }
+        if( ipc::inline_header::get_block( small_0 ) == ipc::inline_header::get_block( small_1 ) )
+        {
+            FAIL( "small record for node 1000 came out of node 0's slab" );
+        }
+        auto *small_0b  = ipc::buffer::allocate_record( tls_prod, small, channel_id, 0 );
+        auto *big_0b    = (std::uint8_t*) ipc::buffer::allocate_record( tls_prod, big, channel_id, 0 );
+        if( ipc::inline_header::get_block( small_0b ) != ipc::inline_header::get_block( small_0 ) )
+        {
+            FAIL( "node 0 slab not picked back up" );
+        }
+        /** straight on from where node 0's run left off **/
+        if( big_0b != big_0 + big_0_bytes + ipc::inline_header::header_size )
+        {
+            FAIL( "node 0 run not picked back up" );
+        }
+        if( ! info.parked[ 0 ].valid || info.parked[ 0 ].node != 1000 || info.run_node != 0 )
+        {
+            FAIL( "node 1000 run wasn't parked" );
+        }
+        for( auto *ptr : { small_0, (void*) big_0, small_1, big_1, small_0b, (void*) big_0b } )
+        {
+            ipc::buffer::free_record( tls_prod, ptr );
+        }
+    }
+#endif
+    
+    ipc::buffer::unlink_channels( tls_prod );
+    ipc::buffer::unlink_channels( tls_cons );
+    ipc::buffer::close_tls_structure( tls_prod );
+    ipc::buffer::close_tls_structure( tls_cons );
+
+    const auto final_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
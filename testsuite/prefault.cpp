@@ -0,0 +1,168 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 10:41:09 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+struct progress_seen
+{
+    std::size_t calls       = 0;
+    std::size_t last_done   = 0;
+    bool        backwards   = false;
+};
+
+static void on_progress( const ipc::prefault_report &report, void *ctx )
+{
+    auto *seen = reinterpret_cast< progress_seen* >( ctx );
+    seen->calls++;
+    if( report.bytes_done < seen->last_done || report.bytes_done > report.bytes_total )
+    {
+        seen->backwards = true;
+    }
+    seen->last_done = report.bytes_done;
+}
+
+/** pages of [data, data + bytes) resident in this process **/
+static std::size_t resident_pages( void *data, const std::size_t bytes )
+{
+    const auto page_bytes = static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) );
+    std::vector< unsigned char > vec( ( bytes + page_bytes - 1 ) / page_bytes );
+    if( mincore( data, bytes, vec.data() ) != 0 )
+    {
+        return( 0 );
+    }
+    std::size_t count = 0;
+    for( const auto v : vec )
+    {
+        count += ( v & 1 );
+    }
+    return( count );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 47 );
+
+    ipc::buffer_config config;
+    config.buffer_size_pow_two  = 26;
+    config.prefault             = ipc::prefault_touch;
+    config.prefault_threads     = 4;
+
+    progress_seen        seen;
+    ipc::prefault_report report;
+    report.progress = on_progress;
+    report.ctx      = &seen;
+
+    auto *buffer = ipc::buffer::initialize( key, config, &report );
+    if( buffer == nullptr )
+    {
+        std::cerr << "failed to initialize buffer\n";
+        return( EXIT_FAILURE );
+    }
+    const auto bytes = buffer->databuffer_size;
+    if( report.mode != ipc::prefault_touch || report.bytes_total != bytes ||
+        report.bytes_done != bytes || report.threads != 4 )
+    {
+        FAIL( "bad report, mode " << int( report.mode ) << " done " << 
+              report.bytes_done << " of " << report.bytes_total );
+    }
+    if( seen.calls == 0 || seen.backwards || seen.last_done != bytes )
+    {
+        FAIL( "progress wasn't reported as it went" );
+    }
+    const auto page_bytes = static_cast< std::size_t >( sysconf( _SC_PAGESIZE ) );
+    if( resident_pages( &buffer->data, bytes ) != bytes / page_bytes )
+    {
+        FAIL( "not every page was faulted in" );
+    }
+    std::cout << "touch prefault of " << ( bytes >> 20 ) << "MiB took " 
+              << report.elapsed.count() << "us\n";
+
+    /** prefaulting under live data mustn't change it **/
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+    const auto nbytes = ( 1 << 16 );
+    auto *record = (std::uint8_t*) ipc::buffer::allocate_record( tls, nbytes, channel_id );
+    if( record == nullptr )
+    {
+        FAIL( "failed to allocate" );
+    }
+    for( auto i( 0 ); i < nbytes; i++ )
+    {
+        record[ i ] = i & 0xff;
+    }
+
+    /** an attaching process asks for its own, populate or its fallback **/
+    ipc::buffer_config attach_config;
+    attach_config.prefault  = ipc::prefault_populate;
+    ipc::prefault_report attach_report;
+    auto *attached = ipc::buffer::initialize( key, attach_config, &attach_report );
+    if( attached == nullptr || attach_report.bytes_done != bytes ||
+        ( attach_report.mode != ipc::prefault_populate && 
+          attach_report.mode != ipc::prefault_touch ) )
+    {
+        FAIL( "attach didn't prefault" );
+    }
+    if( resident_pages( &attached->data, bytes ) != bytes / page_bytes )
+    {
+        FAIL( "not every page was faulted in on attach" );
+    }
+    ipc::buffer::destruct( attached, key, false /** unlink **/ );
+
+    if( ! ipc::buffer::prefault( &buffer->data, bytes, ipc::prefault_willneed ) ||
+        ! ipc::buffer::prefault( &buffer->data, bytes, ipc::prefault_touch, 2 ) )
+    {
+        FAIL( "prefault failed" );
+    }
+    for( auto i( 0 ); i < nbytes; i++ )
+    {
+        if( record[ i ] != ( i & 0xff ) )
+        {
+            FAIL( "prefault changed the record at " << i );
+        }
+    }
+    ipc::buffer::free_record( tls, record );
+    ipc::buffer::close_tls_structure( tls );
+
+    /** out of range mode **/
+    ipc::buffer_config bad;
+    bad.prefault = static_cast< ipc::prefault_mode >( ipc::prefault_touch + 1 );
+    if( bad.valid() )
+    {
+        FAIL( "bad prefault mode accepted" );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,113 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 18:58:47 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto channel_id   = 1;
+    auto *tls_prod = ipc::buffer::get_tls_structure( buffer, getpid() );
+    auto *tls_cons = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls_prod, channel_id, ipc::producer ) == ipc::channel_err ||
+        ipc::buffer::add_spsc_lf_record_channel( tls_cons, channel_id, ipc::consumer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+    if( ! ipc::buffer::enable_recycling( tls_cons, channel_id ) )
+    {
+        FAIL( "failed to enable recycling" );
+    }
+
+    const auto nbytes = ( 2 << ipc::block_size_power_two );
+    auto *first = ipc::buffer::allocate_record( tls_prod, nbytes, channel_id );
+    const auto current_free = [&](){ 
+        return( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) ); 
+    };
+    const auto after_first = current_free();
+    
+    /** every record the consumer frees should come straight back **/
+    void *out = first;
+    for( auto i( 0 ); i < 1000; i++ )
+    {
+        std::memset( out, i & 0xff, nbytes );
+        while( ipc::buffer::send_record( tls_prod, channel_id, &out ) != ipc::tx_success );
+        void *in = nullptr;
+        while( ipc::buffer::receive_record( tls_cons, channel_id, &in ) != ipc::tx_success );
+        if( ((std::uint8_t*)in)[ nbytes - 1 ] != ( i & 0xff ) )
+        {
+            FAIL( "record " << i << " corrupted" );
+        }
+        ipc::buffer::free_record( tls_cons, in );
+        out = ipc::buffer::allocate_record( tls_prod, nbytes, channel_id );
+        if( out != first )
+        {
+            FAIL( "record " << i << " not recycled" );
+        }
+    }
+    if( current_free() != after_first || ! tls_cons->magazine.empty() )
+    {
+        FAIL( "recycled records went through the allocator" );
+    }
+
+    /** producer freeing its own record doesn't go on the lane **/
+    ipc::buffer::free_record( tls_prod, out );
+    if( tls_prod->magazine.empty() )
+    {
+        FAIL( "producer free should go to its magazine" );
+    }
+
+    /** a record the producer never picks back up is drained on unlink **/
+    out = ipc::buffer::allocate_record( tls_prod, nbytes, channel_id );
+    while( ipc::buffer::send_record( tls_prod, channel_id, &out ) != ipc::tx_success );
+    void *in = nullptr;
+    while( ipc::buffer::receive_record( tls_cons, channel_id, &in ) != ipc::tx_success );
+    ipc::buffer::free_record( tls_cons, in );
+
+    ipc::buffer::unlink_channels( tls_prod );
+    ipc::buffer::unlink_channels( tls_cons );
+    ipc::buffer::close_tls_structure( tls_prod );
+    ipc::buffer::close_tls_structure( tls_cons );
+
+    const auto final_free = current_free();
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,138 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 17:12:48 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 49 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    /** schedule first, doesn't need the buffer **/
+    ipc::refill_policy policy;
+    if( policy.next( 1 ) != ipc::refill_policy::min_blocks )
+    {
+        FAIL( "first refill should be the minimum" );
+    }
+    if( policy.next( ipc::refill_policy::min_blocks ) !=
+            ( ipc::refill_policy::min_blocks * ipc::refill_policy::records_per_refill ) )
+    {
+        FAIL( "refill doesn't cover the record" );
+    }
+    for( auto i( 0 ); i < 32; i++ )
+    {
+        policy.next( 1 );
+    }
+    if( policy.target != ipc::refill_policy::max_blocks )
+    {
+        FAIL( "back to back refills didn't grow to the max, at " << policy.target );
+    }
+    policy.last -= std::chrono::seconds( 1 );
+    if( policy.next( 1 ) != ( ipc::refill_policy::max_blocks >> 1 ) )
+    {
+        FAIL( "slow refill didn't shrink" );
+    }
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+    auto &info = tls->channel_local_allocation[ channel_id ];
+
+    /** 16KiB + header, five blocks each, three to the first refill **/
+    const auto nbytes = ( 1 << 14 );
+    std::vector< void* > records;
+    auto *first = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+    if( first == nullptr )
+    {
+        FAIL( "failed to allocate" );
+    }
+    records.push_back( first );
+    const auto record_blocks = 
+        ( ipc::buffer::get_record_size( tls, first ) + ipc::inline_header::header_size ) >>
+            ipc::block_size_power_two;
+    const auto run_blocks = info.blocks_available + record_blocks;
+    if( run_blocks != std::max( ipc::refill_policy::min_blocks, 
+                                record_blocks * ipc::refill_policy::records_per_refill ) )
+    {
+        FAIL( "first refill is " << run_blocks << " blocks" );
+    }
+
+    /** run through the rest of it, what's left over is kept **/
+    while( info.refill.refills == 1 )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate" );
+        }
+        records.push_back( ptr );
+    }
+    if( info.spare_blocks != ( run_blocks % record_blocks ) )
+    {
+        FAIL( "leftover tail not kept, spare " << info.spare_blocks << 
+            " expected " << ( run_blocks % record_blocks ) );
+    }
+
+    /** a fast producer stops going back to the heap every few records **/
+    for( auto i( 0 ); i < 4096; i++ )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate" );
+        }
+        records.push_back( ptr );
+    }
+    if( info.refill.refills > 64 )
+    {
+        FAIL( "refill size didn't grow, " << info.refill.refills << " refills" );
+    }
+
+    for( auto *ptr : records )
+    {
+        ipc::buffer::free_record( tls, ptr );
+    }
+    ipc::buffer::close_tls_structure( tls );
+    if( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) != initial_free )
+    {
+        FAIL( "blocks leaked, " <<
+            ( initial_free - ipc::meta_info::heap_t::get_current_free( &buffer->heap ) ) );
+    }
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,223 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 23:40:26 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; exit( EXIT_FAILURE ); }
+
+using gate_t = std::atomic< int >;
+
+/** variable length messages, sequence number then seq & 0xff filler **/
+static std::size_t message_length( const std::uint64_t seq )
+{
+    return( sizeof( std::uint64_t ) + ( ( seq * 37 ) % 300 ) );
+}
+
+void producer(  const std::uint64_t count,
+                const ipc::channel_id_t channel_id,
+                ipc::buffer *buffer,
+                gate_t &g )
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "producer failed to add channel" );
+    }
+    g++;
+    while( g != 2 ){ __asm__ volatile ( "nop" : : : ); }
+
+    for( std::uint64_t i( 0 ); i < count; i++ )
+    {
+        /** reserve the most it could be, encode, commit what it came to **/
+        void *span = nullptr;
+        while( ipc::buffer::reserve_data( tls, channel_id, 512, &span ) != ipc::tx_success );
+        const auto length = message_length( i );
+        *(std::uint64_t*) span = i;
+        std::memset( (std::uint8_t*) span + sizeof( i ), int( i & 0xff ), length - sizeof( i ) );
+        if( ipc::buffer::commit_data( tls, channel_id, length ) != ipc::tx_success )
+        {
+            FAIL( "commit failed at " << i );
+        }
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+}
+
+void consumer(  const std::uint64_t count,
+                const ipc::channel_id_t channel_id,
+                ipc::buffer *buffer,
+                gate_t &g )
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::consumer ) == ipc::channel_err )
+    {
+        FAIL( "consumer failed to add channel" );
+    }
+    g++;
+    while( g != 2 ){ __asm__ volatile ( "nop" : : : ); }
+
+    for( std::uint64_t i( 0 ); i < count; i++ )
+    {
+        const void  *span   = nullptr;
+        std::size_t length  = 0;
+        while( ipc::buffer::peek_data( tls, channel_id, &span, length ) != ipc::tx_success );
+        const auto *bytes = (const std::uint8_t*) span;
+        if( *(const std::uint64_t*) span != i || length != message_length( i ) )
+        {
+            FAIL( "got " << *(const std::uint64_t*) span << " (" << length << "B) expected " << i );
+        }
+        for( std::size_t b( sizeof( i ) ); b < length; b++ )
+        {
+            if( bytes[ b ] != std::uint8_t( i & 0xff ) )
+            {
+                FAIL( "bad payload in " << i );
+            }
+        }
+        if( ipc::buffer::release_data( tls, channel_id ) != ipc::tx_success )
+        {
+            FAIL( "release failed at " << i );
+        }
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 54 );
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    /** single thread first, the error cases and in place round trip **/
+    {
+        const auto channel_id = 1;
+        auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+        if( ipc::buffer::add_spsc_lf_record_channel( tls, 2, ipc::producer ) == ipc::channel_err ||
+            ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+        {
+            FAIL( "failed to add channels" );
+        }
+        void *span = nullptr;
+        if( ipc::buffer::reserve_data( tls, 2, 8, &span ) != ipc::tx_error ||
+            ipc::buffer::reserve_data( tls, 3, 8, &span ) != ipc::no_such_channel ||
+            ipc::buffer::reserve_data( tls, channel_id,
+                ipc::meta_info::spsc_data::default_ring_bytes, &span ) != ipc::tx_error )
+        {
+            FAIL( "bad reserve accepted" );
+        }
+        if( ipc::buffer::commit_data( tls, channel_id, 0 ) != ipc::tx_error ||
+            ipc::buffer::release_data( tls, channel_id ) != ipc::tx_error )
+        {
+            FAIL( "commit/release without reserve/peek" );
+        }
+        if( ipc::buffer::reserve_data( tls, channel_id, 100, &span ) != ipc::tx_success )
+        {
+            FAIL( "reserve failed" );
+        }
+        std::memset( span, 0x2a, 37 );
+        if( ipc::buffer::commit_data( tls, channel_id, 101 ) != ipc::tx_error ||
+            ipc::buffer::commit_data( tls, channel_id, 37 ) != ipc::tx_success ||
+            ipc::buffer::commit_data( tls, channel_id, 37 ) != ipc::tx_error )
+        {
+            FAIL( "commit didn't check the reserve" );
+        }
+        const void *in_place = nullptr;
+        std::size_t length   = 0;
+        if( ipc::buffer::peek_data( tls, channel_id, &in_place, length ) != ipc::tx_success ||
+            in_place != span || length != 37 || ( (const std::uint8_t*) in_place )[ 36 ] != 0x2a )
+        {
+            FAIL( "peek didn't give back the committed span" );
+        }
+        if( ipc::buffer::release_data( tls, channel_id ) != ipc::tx_success ||
+            ipc::buffer::peek_data( tls, channel_id, &in_place, length ) != ipc::tx_retry )
+        {
+            FAIL( "release didn't consume the message" );
+        }
+        ipc::buffer::unlink_channels( tls );
+        ipc::buffer::close_tls_structure( tls );
+    }
+
+    /** a failed reserve that wrapped drops the one before it **/
+    {
+        const auto channel_id = 3;
+        auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+        if( ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::producer,
+                ipc::meta_info::spsc_data::min_ring_bytes ) == ipc::channel_err )
+        {
+            FAIL( "failed to add channel" );
+        }
+        /** head at 8, tail at 3584, 512B to the end of the 4KiB ring **/
+        void *span = nullptr;
+        const void *in_place = nullptr;
+        std::size_t length   = 0;
+        if( ipc::buffer::reserve_data( tls, channel_id, 0, &span ) != ipc::tx_success ||
+            ipc::buffer::commit_data( tls, channel_id, 0 ) != ipc::tx_success ||
+            ipc::buffer::peek_data( tls, channel_id, &in_place, length ) != ipc::tx_success ||
+            ipc::buffer::release_data( tls, channel_id ) != ipc::tx_success ||
+            ipc::buffer::reserve_data( tls, channel_id, 3568, &span ) != ipc::tx_success ||
+            ipc::buffer::commit_data( tls, channel_id, 3568 ) != ipc::tx_success )
+        {
+            FAIL( "failed to fill the ring" );
+        }
+        if( ipc::buffer::reserve_data( tls, channel_id, 100, &span ) != ipc::tx_success )
+        {
+            FAIL( "reserve before the end of the ring failed" );
+        }
+        /** doesn't fit before the end, filler goes in, no room at the front **/
+        if( ipc::buffer::reserve_data( tls, channel_id, 600, &span ) != ipc::tx_retry )
+        {
+            FAIL( "reserve past the end of a full ring didn't retry" );
+        }
+        if( ipc::buffer::commit_data( tls, channel_id, 50 ) != ipc::tx_error )
+        {
+            FAIL( "commit went through on a reserve that was dropped" );
+        }
+        /** only the 3568B message is there, the filler is stepped over **/
+        if( ipc::buffer::peek_data( tls, channel_id, &in_place, length ) != ipc::tx_success ||
+            length != 3568 ||
+            ipc::buffer::release_data( tls, channel_id ) != ipc::tx_success ||
+            ipc::buffer::peek_data( tls, channel_id, &in_place, length ) != ipc::tx_retry )
+        {
+            FAIL( "ring doesn't hold what was committed" );
+        }
+        ipc::buffer::unlink_channels( tls );
+        ipc::buffer::close_tls_structure( tls );
+    }
+
+    const auto channel_id = 4;
+    gate_t gate = {0};
+    const std::uint64_t count = ( 1 << 18 );
+    std::thread source( producer, count, channel_id, buffer, std::ref( gate ) );
+    std::thread dest  ( consumer, count, channel_id, buffer, std::ref( gate ) );
+    source.join();
+    dest.join();
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,137 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 21:03:44 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 52 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+    auto *tls_prod = ipc::buffer::get_tls_structure( buffer, getpid() );
+    auto *tls_cons = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    for( const std::size_t bad : { std::size_t( 32 ), std::size_t( 100 ), std::size_t( 1 << 21 ) } )
+    {
+        if( ipc::buffer::add_spsc_lf_record_channel( tls_prod, 1, ipc::producer, 0,
+                ipc::any_numa_node, bad ) != ipc::channel_err )
+        {
+            FAIL( "ring depth " << bad << " accepted" );
+        }
+    }
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    /** shallow ring in spsc_q, deep one behind the channel **/
+    for( const std::size_t depth : { std::size_t( 64 ), std::size_t( 4096 ) } )
+    {
+        const ipc::channel_id_t channel_id = depth;
+        if( ipc::buffer::add_spsc_lf_record_channel( tls_prod, channel_id, ipc::producer, 0,
+                ipc::any_numa_node, depth ) == ipc::channel_err ||
+            /** depth is the creator's, this one is ignored **/
+            ipc::buffer::add_spsc_lf_record_channel( tls_cons, channel_id, ipc::consumer, 0,
+                ipc::any_numa_node, 128 ) == ipc::channel_err )
+        {
+            FAIL( "failed to add channel with depth " << depth );
+        }
+        if( ipc::meta_info::spsc_lock_free::depth( tls_cons->channel_map[ channel_id ] ) != depth )
+        {
+            FAIL( "channel depth is " <<
+                ipc::meta_info::spsc_lock_free::depth( tls_cons->channel_map[ channel_id ] ) );
+        }
+
+        std::vector< void* > records;
+        for( std::size_t i( 0 ); i < depth + 1; i++ )
+        {
+            auto *record = (std::uint64_t*)
+                ipc::buffer::allocate_record( tls_prod, sizeof( std::uint64_t ), channel_id );
+            if( record == nullptr )
+            {
+                FAIL( "failed to allocate" );
+            }
+            *record = i;
+            records.push_back( record );
+        }
+        for( std::size_t i( 0 ); i < depth; i++ )
+        {
+            if( ipc::buffer::send_record( tls_prod, channel_id, &records[ i ] ) != ipc::tx_success )
+            {
+                FAIL( "send " << i << " failed on a ring of " << depth );
+            }
+        }
+        if( ipc::buffer::send_record( tls_prod, channel_id, &records[ depth ] ) != ipc::tx_retry )
+        {
+            FAIL( "ring of " << depth << " took " << ( depth + 1 ) );
+        }
+        /** drain, then push half around the wrap a few times **/
+        std::size_t expected = 0;
+        std::size_t sent     = depth;
+        auto receive = [&]( const std::size_t n )
+        {
+            for( std::size_t i( 0 ); i < n; i++ )
+            {
+                void *record = nullptr;
+                while( ipc::buffer::receive_record( tls_cons, channel_id, &record ) != ipc::tx_success );
+                if( *(std::uint64_t*) record != expected )
+                {
+                    FAIL( "got " << *(std::uint64_t*) record << " expected " << expected );
+                }
+                expected++;
+                ipc::buffer::free_record( tls_cons, record );
+            }
+        };
+        receive( depth );
+        ipc::buffer::free_record( tls_prod, records[ depth ] );
+        for( auto round( 0 ); round < 8; round++ )
+        {
+            for( std::size_t i( 0 ); i < ( depth >> 1 ); i++, sent++ )
+            {
+                auto *record = (std::uint64_t*)
+                    ipc::buffer::allocate_record( tls_prod, sizeof( std::uint64_t ), channel_id );
+                *record = sent;
+                if( ipc::buffer::send_record( tls_prod, channel_id, (void**) &record ) != ipc::tx_success )
+                {
+                    FAIL( "send failed after drain" );
+                }
+            }
+            receive( depth >> 1 );
+        }
+    }
+    ipc::buffer::unlink_channels( tls_prod );
+    ipc::buffer::unlink_channels( tls_cons );
+    ipc::buffer::close_tls_structure( tls_prod );
+    ipc::buffer::close_tls_structure( tls_cons );
+    if( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) != initial_free )
+    {
+        FAIL( "channel blocks leaked" );
+    }
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,137 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 10:02:13 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto channel_id = 1;
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &tls->buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /**
+     * 1024 x 16B records, without the slab each of these would
+     * need a data block and a meta block, so 2048 blocks. With
+     * the slab they should fit in a handful of blocks taken from
+     * the first thread local run.
+     */
+    const auto count = 1024;
+    std::vector< std::uint8_t* > records;
+    std::set< std::uint8_t* >    unique;
+    for( auto i( 0 ); i < count; i++ )
+    {
+        auto *ptr = (std::uint8_t*) ipc::buffer::allocate_record( tls, 16, channel_id );
+        if( ptr == nullptr )
+        {
+            FAIL( "failed to allocate record " << i );
+        }
+        if( ipc::buffer::get_record_size( tls, ptr ) != 16 )
+        {
+            FAIL( "wrong record size, got " << ipc::buffer::get_record_size( tls, ptr ) );
+        }
+        std::memset( ptr, i & 0xff, 16 );
+        records.push_back( ptr );
+        unique.insert( ptr );
+    }
+    if( unique.size() != count )
+    {
+        FAIL( "slab handed out the same record twice" );
+    }
+    for( auto i( 0 ); i < count; i++ )
+    {
+        for( auto j( 0 ); j < 16; j++ )
+        {
+            if( records[ i ][ j ] != ( i & 0xff ) )
+            {
+                FAIL( "record " << i << " overwritten" );
+            }
+        }
+    }
+
+    const auto used_blocks = initial_free -
+        ipc::meta_info::heap_t::get_current_free( &tls->buffer->heap );
+    /**
+     * four channel blocks + one 256 block thread local run,
+     * anything more means the slab isn't packing records.
+     */
+    if( used_blocks > 260 )
+    {
+        FAIL( "too many blocks used for small records: " << used_blocks );
+    }
+
+    /** different sizes should land in different slabs **/
+    auto *small = ipc::buffer::allocate_record( tls, 8,    channel_id );
+    auto *big   = ipc::buffer::allocate_record( tls, 2000, channel_id );
+    if( ipc::slab::get_header( small ) == ipc::slab::get_header( big ) ||
+        ipc::buffer::get_record_size( tls, big ) != ipc::slab::max_record_size )
+    {
+        FAIL( "size classes not separated" );
+    }
+    /** anything past the top class goes to the normal block path **/
+    auto *block = ipc::buffer::allocate_record( tls, 4096, channel_id );
+    if( ipc::slab::is_slab_record( block ) ||
+        ipc::buffer::get_record_size( tls, block ) < 4096 )
+    {
+        FAIL( "large record should be block allocated" );
+    }
+
+    for( auto *ptr : records )
+    {
+        ipc::buffer::free_record( tls, ptr );
+    }
+    ipc::buffer::free_record( tls, small );
+    ipc::buffer::free_record( tls, big );
+    ipc::buffer::free_record( tls, block );
+
+    ipc::buffer::close_tls_structure( tls );
+
+    /** everything, slabs included, should be back in the heap **/
+    const auto final_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
@@ -0,0 +1,204 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sat Oct 17 17:52:30 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 42 );
+
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto channel_id   = 1;
+    const auto arena_bytes  = ( 1 << 16 );
+    auto *tls_prod = ipc::buffer::get_tls_structure( buffer, getpid() );
+    auto *tls_cons = ipc::buffer::get_tls_structure( buffer, getpid() );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    if( ipc::buffer::add_spsc_lf_record_channel( tls_prod, channel_id, ipc::producer, arena_bytes ) == ipc::channel_err ||
+        ipc::buffer::add_spsc_lf_record_channel( tls_cons, channel_id, ipc::consumer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+    if( buffer->arenas.used.load() != 1 )
+    {
+        FAIL( "arena wasn't put in the buffer's arena map" );
+    }
+    /** same check the free path makes, doesn't depend on any TLS **/
+    const auto in_arena = [&]( const void * const ptr ){
+        return( buffer->arenas.contains( 
+            ipc::buffer::calculate_block_offset( &buffer->data, ptr ) ) );
+    };
+
+    const auto current_free = [&](){ 
+        return( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) ); 
+    };
+    const auto after_channel = current_free();
+
+    /** 
+     * send/receive/free in lock step with a mix of sizes, wraps the
+     * arena many times, nothing should come from the heap.
+     */
+    for( std::uint32_t i( 0 ); i < ( 1 << 16 ); i++ )
+    {
+        const std::size_t nbytes = 8 + ( ( i * 97 ) % 3000 );
+        auto *out = (std::uint8_t*) ipc::buffer::allocate_record( tls_prod, nbytes, channel_id );
+        if( ! in_arena( out ) )
+        {
+            FAIL( "record " << i << " not from the arena" );
+        }
+        if( ipc::buffer::get_record_size( tls_prod, out ) < nbytes )
+        {
+            FAIL( "record " << i << " too small" );
+        }
+        std::memset( out, i & 0xff, nbytes );
+        while( ipc::buffer::send_record( tls_prod, channel_id, (void**)&out ) != ipc::tx_success );
+        
+        void *in = nullptr;
+        while( ipc::buffer::receive_record( tls_cons, channel_id, &in ) != ipc::tx_success );
+        for( std::size_t j( 0 ); j < nbytes; j++ )
+        {
+            if( ((std::uint8_t*)in)[ j ] != ( i & 0xff ) )
+            {
+                FAIL( "record " << i << " corrupted" );
+            }
+        }
+        ipc::buffer::free_record( tls_cons, in );
+    }
+    if( current_free() != after_channel )
+    {
+        FAIL( "arena records went through the heap" );
+    }
+
+    /** fill the arena without freeing, once full we fall back to the heap **/
+    std::vector< void* > held;
+    void *spill = nullptr;
+    for( auto i( 0 ); i <= ( arena_bytes / 64 ); i++ )
+    {
+        auto *ptr = ipc::buffer::allocate_record( tls_prod, 16, channel_id );
+        if( ! in_arena( ptr ) )
+        {
+            spill = ptr;
+            break;
+        }
+        held.push_back( ptr );
+    }
+    if( spill == nullptr || held.empty() )
+    {
+        FAIL( "full arena should spill to the heap" );
+    }
+    ipc::buffer::free_record( tls_prod, spill );
+
+    /** out of order, freeing the newest doesn't give anything back **/
+    ipc::buffer::free_record( tls_cons, held.back() );
+    held.pop_back();
+    auto *ptr = ipc::buffer::allocate_record( tls_prod, 16, channel_id );
+    if( in_arena( ptr ) )
+    {
+        FAIL( "tail moved past a live record" );
+    }
+    ipc::buffer::free_record( tls_prod, ptr );
+    /** once the oldest go the space comes back **/
+    for( auto *record : held )
+    {
+        ipc::buffer::free_record( tls_cons, record );
+    }
+    ptr = ipc::buffer::allocate_record( tls_prod, 16, channel_id );
+    if( ! in_arena( ptr ) )
+    {
+        FAIL( "arena space not reclaimed" );
+    }
+    ipc::buffer::free_record( tls_cons, ptr );
+
+    /**
+     * a thread that never opened the channel frees arena records, 
+     * has to find them without anything in its own TLS.
+     */
+    std::vector< void* > handed_off;
+    for( auto i( 0 ); i < 4; i++ )
+    {
+        auto *out = ipc::buffer::allocate_record( tls_prod, 3000, channel_id );
+        if( ! in_arena( out ) )
+        {
+            FAIL( "record " << i << " for the other thread not from the arena" );
+        }
+        while( ipc::buffer::send_record( tls_prod, channel_id, (void**)&out ) != ipc::tx_success );
+        void *in = nullptr;
+        while( ipc::buffer::receive_record( tls_cons, channel_id, &in ) != ipc::tx_success );
+        handed_off.push_back( in );
+    }
+    const auto before_other = current_free();
+    std::thread other( [&](){
+        auto *tls_other = ipc::buffer::get_tls_structure( buffer, getpid() );
+        for( auto *record : handed_off )
+        {
+            if( ipc::buffer::get_record_size( tls_other, record ) < 3000 )
+            {
+                FAIL( "other thread got the wrong record size" );
+            }
+            ipc::buffer::free_record( tls_other, record );
+        }
+        ipc::buffer::close_tls_structure( tls_other );
+    } );
+    other.join();
+    if( current_free() != before_other )
+    {
+        FAIL( "arena records freed by the other thread went to the heap" );
+    }
+    /** all four came back to the arena, so a full half arena fits again **/
+    ptr = ipc::buffer::allocate_record( tls_prod, ( arena_bytes >> 1 ) - 64, channel_id );
+    if( ! in_arena( ptr ) )
+    {
+        FAIL( "arena space freed by the other thread not reclaimed" );
+    }
+    ipc::buffer::free_record( tls_cons, ptr );
+    
+    ipc::buffer::unlink_channels( tls_prod );
+    ipc::buffer::unlink_channels( tls_cons );
+    ipc::buffer::close_tls_structure( tls_prod );
+    ipc::buffer::close_tls_structure( tls_cons );
+
+    if( buffer->arenas.contains( ipc::buffer::calculate_block_offset( &buffer->data, ptr ) ) )
+    {
+        FAIL( "arena still in the map after the channel went away" );
+    }
+
+    const auto final_free = current_free();
+    if( final_free != initial_free )
+    {
+        FAIL( "leaked blocks, started with " << initial_free << " ended with " << final_free );
+    }
+
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
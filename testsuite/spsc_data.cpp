@@ -0,0 +1,207 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 22:58:12 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; exit( EXIT_FAILURE ); }
+
+using gate_t = std::atomic< int >;
+
+/** 64B telemetry events, first word is the sequence number **/
+struct event
+{
+    std::uint64_t seq;
+    std::uint8_t  body[ 56 ];
+};
+
+void producer(  const std::uint64_t count,
+                const ipc::channel_id_t channel_id,
+                ipc::buffer *buffer,
+                gate_t &g )
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "producer failed to add channel" );
+    }
+    g++;
+    while( g != 2 ){ __asm__ volatile ( "nop" : : : ); }
+
+    event e;
+    for( std::uint64_t i( 0 ); i < count; i++ )
+    {
+        e.seq = i;
+        std::memset( e.body, int( i & 0xff ), sizeof( e.body ) );
+        /** odd lengths too, so frames aren't all the same size **/
+        const auto length = sizeof( e ) - ( i % 3 );
+        while( ipc::buffer::send_data( tls, channel_id, &e, length ) != ipc::tx_success );
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+}
+
+void consumer(  const std::uint64_t count,
+                const ipc::channel_id_t channel_id,
+                ipc::buffer *buffer,
+                gate_t &g )
+{
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if( ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::consumer ) == ipc::channel_err )
+    {
+        FAIL( "consumer failed to add channel" );
+    }
+    g++;
+    while( g != 2 ){ __asm__ volatile ( "nop" : : : ); }
+
+    event e;
+    for( std::uint64_t i( 0 ); i < count; i++ )
+    {
+        std::size_t length = 0;
+        while( ipc::buffer::receive_data( tls, channel_id, &e, sizeof( e ), length ) != ipc::tx_success );
+        if( e.seq != i || length != sizeof( e ) - ( i % 3 ) )
+        {
+            FAIL( "got " << e.seq << " (" << length << "B) expected " << i );
+        }
+        for( std::size_t b( 0 ); b < length - sizeof( e.seq ); b++ )
+        {
+            if( e.body[ b ] != std::uint8_t( i & 0xff ) )
+            {
+                FAIL( "bad payload in " << i );
+            }
+        }
+    }
+    ipc::buffer::unlink_channels( tls );
+    ipc::buffer::close_tls_structure( tls );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 53 );
+    auto *buffer = ipc::buffer::initialize( key  );
+
+    const auto initial_free =
+        ipc::meta_info::heap_t::get_current_free( &buffer->heap );
+
+    /** single thread first, fill, wrap and the error cases **/
+    {
+        auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+        for( const std::size_t bad : { std::size_t( 1024 ), std::size_t( 5000 ) } )
+        {
+            if( ipc::buffer::add_spsc_data_channel( tls, 1, ipc::producer, bad ) != ipc::channel_err )
+            {
+                FAIL( "ring of " << bad << " bytes accepted" );
+            }
+        }
+        const auto channel_id   = 1;
+        const auto ring_bytes   = ipc::meta_info::spsc_data::min_ring_bytes;
+        if( ipc::buffer::add_spsc_data_channel( tls, channel_id, ipc::producer, ring_bytes ) == ipc::channel_err )
+        {
+            FAIL( "failed to add channel" );
+        }
+        std::uint8_t out[ 128 ];
+        std::size_t  length = 0;
+        if( ipc::buffer::receive_data( tls, channel_id, out, sizeof( out ), length ) != ipc::tx_retry )
+        {
+            FAIL( "received from an empty ring" );
+        }
+        std::uint8_t big[ ring_bytes ] = {};
+        if( ipc::buffer::send_data( tls, channel_id, big, sizeof( big ) ) != ipc::tx_error )
+        {
+            FAIL( "sent a message bigger than the ring" );
+        }
+
+        /** 40B messages, 48B frames, 85 fit in 4KiB **/
+        const std::size_t msg   = 40;
+        const std::size_t fits  = ring_bytes / ipc::meta_info::spsc_data::frame_bytes( msg );
+        std::uint8_t in[ msg ];
+        std::size_t sent = 0;
+        for( ;; sent++ )
+        {
+            std::memset( in, int( sent ), msg );
+            if( ipc::buffer::send_data( tls, channel_id, in, msg ) != ipc::tx_success )
+            {
+                break;
+            }
+        }
+        if( sent != fits )
+        {
+            FAIL( "ring took " << sent << " expected " << fits );
+        }
+        if( ipc::buffer::receive_data( tls, channel_id, out, msg - 1, length ) != ipc::tx_error ||
+            length != msg )
+        {
+            FAIL( "message didn't stay put when it didn't fit" );
+        }
+        /** drain half, refill past the end of the ring, drain it all in order **/
+        std::size_t next = 0;
+        auto receive = [&]( const std::size_t n )
+        {
+            for( std::size_t i( 0 ); i < n; i++, next++ )
+            {
+                if( ipc::buffer::receive_data( tls, channel_id, out, sizeof( out ), length ) != ipc::tx_success ||
+                    length != msg || out[ 0 ] != std::uint8_t( next ) || out[ msg - 1 ] != std::uint8_t( next ) )
+                {
+                    FAIL( "bad message " << next );
+                }
+            }
+        };
+        receive( fits >> 1 );
+        for( std::size_t i( 0 ); i < ( fits >> 1 ); i++, sent++ )
+        {
+            std::memset( in, int( sent ), msg );
+            if( ipc::buffer::send_data( tls, channel_id, in, msg ) != ipc::tx_success )
+            {
+                FAIL( "send across the end of the ring failed at " << i );
+            }
+        }
+        receive( sent - next );
+        if( ipc::buffer::channel_has_data( tls, channel_id ) != 0 )
+        {
+            FAIL( "drained ring has data" );
+        }
+        ipc::buffer::unlink_channels( tls );
+        ipc::buffer::close_tls_structure( tls );
+    }
+
+    const auto channel_id = 2;
+    gate_t gate = {0};
+    const std::uint64_t count = ( 1 << 18 );
+    std::thread source( producer, count, channel_id, buffer, std::ref( gate ) );
+    std::thread dest  ( consumer, count, channel_id, buffer, std::ref( gate ) );
+    source.join();
+    dest.join();
+
+    if( ipc::meta_info::heap_t::get_current_free( &buffer->heap ) != initial_free )
+    {
+        FAIL( "channel blocks leaked" );
+    }
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}
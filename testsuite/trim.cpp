@@ -0,0 +1,159 @@
+/**
+ * @author: Jonathan Beard
+ * @version: Sun Oct 18 19:02:37 2026
+ *
+ * Copyright 2026 Jonathan Beard
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <buffer>
+
+#define FAIL( MSG ) { std::cerr << MSG << "\n"; ipc::buffer::destruct( buffer, key ); exit( EXIT_FAILURE ); }
+
+/** resident pages in the granules wholly inside [ptr, ptr + bytes) **/
+static std::size_t resident( ipc::buffer *b, void *ptr, const std::size_t bytes )
+{
+    const auto g        = ipc::trim_map::granule_bytes;
+    const auto offset   = reinterpret_cast< std::uintptr_t >( ptr ) -
+                          reinterpret_cast< std::uintptr_t >( &b->data );
+    const auto first    = ( ( offset + g - 1 ) / g ) * g;
+    const auto end      = ( ( offset + bytes ) / g ) * g;
+    const auto page     = std::size_t( sysconf( _SC_PAGESIZE ) );
+    std::vector< unsigned char > vec( g / page );
+    std::size_t count = 0;
+    for( auto o( first ); o < end; o += g )
+    {
+        if( mincore( reinterpret_cast< ipc::byte_t* >( &b->data ) + o, g, vec.data() ) != 0 )
+        {
+            return( 0 );
+        }
+        for( const auto v : vec )
+        {
+            count += ( v & 1 );
+        }
+    }
+    return( count );
+}
+
+int main()
+{
+    ipc::buffer::register_signal_handlers();
+    shm_key_t key;
+    ipc::buffer::gen_key( key, 50 );
+
+    ipc::buffer_config config;
+    config.trim_idle_ms = 5;
+    auto *buffer = ipc::buffer::initialize( key, config );
+    if( ipc::buffer::get_config( buffer ).trim_idle_ms != 5 )
+    {
+        FAIL( "trim_idle_ms not recorded" );
+    }
+
+    auto *tls = ipc::buffer::get_tls_structure( buffer, getpid() );
+    if constexpr( ipc::meta_info::heap_t::is_lock_free )
+    {
+        /** never trimmed, see ipc::buffer::trim **/
+        if( ipc::buffer::trim( tls, true ) != 0 )
+        {
+            FAIL( "lock-free heap trimmed" );
+        }
+        ipc::buffer::close_tls_structure( tls );
+        ipc::buffer::destruct( buffer, key );
+        return( EXIT_SUCCESS );
+    }
+
+    const auto channel_id = 1;
+    if( ipc::buffer::add_spsc_lf_record_channel( tls, channel_id, ipc::producer ) == ipc::channel_err )
+    {
+        FAIL( "failed to add channel" );
+    }
+
+    /** bigger than a heap leaf, comes straight from the heap and goes straight back **/
+    const auto nbytes = ( 1 << 23 );
+    auto *record = ipc::buffer::allocate_record( tls, nbytes, channel_id );
+    if( record == nullptr )
+    {
+        FAIL( "failed to allocate" );
+    }
+    std::memset( record, 0xff, nbytes );
+    if( resident( buffer, record, nbytes ) == 0 )
+    {
+        FAIL( "can't see residency, mincore not working" );
+    }
+    ipc::buffer::free_record( tls, record );
+
+    /** not idle long enough yet, only forced or idle trims go **/
+    ipc::buffer::trim( tls );
+    if( resident( buffer, record, nbytes ) == 0 )
+    {
+        FAIL( "trimmed before it was idle" );
+    }
+
+    /** first scan after the idle time sees it free, the next trims it **/
+    for( auto i( 0 ); i < 2; i++ )
+    {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        ipc::buffer::trim( tls );
+    }
+    if( resident( buffer, record, nbytes ) != 0 )
+    {
+        FAIL( "idle record still resident: " << resident( buffer, record, nbytes ) << " pages" );
+    }
+    ipc::alloc_stats_snapshot stats;
+    ipc::buffer::get_stats( tls, stats );
+    if( stats.trim_scans < 2 || stats.reclaimed_bytes < ( nbytes - 2 * ipc::trim_map::granule_bytes ) )
+    {
+        FAIL( "trim counters: " << stats.trim_scans << " scans, " << stats.reclaimed_bytes << " bytes" );
+    }
+
+    /** hand it out again, comes back zeroed and writeable **/
+    auto *again = (std::uint8_t*) ipc::buffer::allocate_record( tls, nbytes, channel_id );
+    if( again == nullptr )
+    {
+        FAIL( "failed to allocate after trim" );
+    }
+    std::memset( again, 0x5a, nbytes );
+    for( auto i( 0 ); i < nbytes; i += 4096 )
+    {
+        if( again[ i ] != 0x5a )
+        {
+            FAIL( "bad data at " << i );
+        }
+    }
+    ipc::buffer::free_record( tls, again );
+
+    /** forced trim doesn't wait **/
+    if( ipc::buffer::trim( tls, true ) < ( nbytes - 2 * ipc::trim_map::granule_bytes ) )
+    {
+        FAIL( "forced trim didn't give the record back" );
+    }
+    if( resident( buffer, again, nbytes ) != 0 )
+    {
+        FAIL( "forced trim left the record resident" );
+    }
+
+    ipc::buffer::close_tls_structure( tls );
+    ipc::buffer::destruct( buffer, key );
+    return( EXIT_SUCCESS );
+}